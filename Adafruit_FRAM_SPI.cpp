@@ -37,31 +37,121 @@
 /// Enable debug output
 #define FRAM_DEBUG 0
 
+#if FRAM_SPI_HOOKS
+/*!
+ *  @brief  Default pre-transfer hook, replaced by any strong definition
+ *  @param  fram
+ *          Instance issuing the transfer
+ *  @param  opcode
+ *          Opcode about to be sent, 0 for a wake pulse
+ *  @param  addr
+ *          Array address, 0 for non-memory opcodes
+ *  @param  length
+ *          Payload bytes about to be moved
+ */
+__attribute__((weak)) void framSPIBeforeTransfer(Adafruit_FRAM_SPI *fram,
+                                                 uint8_t opcode, uint32_t addr,
+                                                 size_t length) {
+  (void)fram;
+  (void)opcode;
+  (void)addr;
+  (void)length;
+}
+
+/*!
+ *  @brief  Default post-transfer hook, replaced by any strong definition
+ *  @param  fram
+ *          Instance that issued the transfer
+ *  @param  opcode
+ *          Opcode sent, 0 for a wake pulse
+ *  @param  addr
+ *          Array address, 0 for non-memory opcodes
+ *  @param  length
+ *          Payload bytes moved
+ *  @param  duration
+ *          Time spent in the transfer, in us
+ *  @param  ok
+ *          Result reported by the SPI layer
+ */
+__attribute__((weak)) void framSPIAfterTransfer(Adafruit_FRAM_SPI *fram,
+                                                uint8_t opcode, uint32_t addr,
+                                                size_t length,
+                                                uint32_t duration, bool ok) {
+  (void)fram;
+  (void)opcode;
+  (void)addr;
+  (void)length;
+  (void)duration;
+  (void)ok;
+}
+#endif
+
+/// One low-power mode of a part
+typedef struct {
+  uint8_t opcode;      ///< Entry opcode, 0 if the part lacks the mode
+  uint16_t wake_us;    ///< Recovery time (tREC) from the CS falling edge
+  uint16_t current_nA; ///< Typical supply current while in the mode
+} fram_lp_mode_t;
+
+/// Supply currents and low-power modes of a part family
+typedef struct {
+  uint16_t read_uA;    ///< Typical operating current while reading
+  uint16_t write_uA;   ///< Typical operating current while writing
+  uint16_t standby_uA; ///< Typical standby current with CS high
+  fram_lp_mode_t lp_modes[FRAM_LP_MODES]; ///< Indexed by fram_lowpower_t
+} fram_power_t;
+
+// Power profiles. Figures are datasheet typicals; check them against the
+// revision of the part in use.
+
+/// Fujitsu MB85RS16/MB85RS64V: no low-power modes
+static const fram_power_t _power_mb85rs_v = {
+    1500, 1500, 10, {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}};
+
+/// Fujitsu MB85RS*T parts: SLEEP only
+static const fram_power_t _power_mb85rs_t = {
+    2000, 2000, 50, {{OPCODE_SLEEP, 400, 10000}, {0, 0, 0}, {0, 0, 0}}};
+
+/// MB85RS4MTY: deep power-down, and hibernate on the SLEEP opcode
+static const fram_power_t _power_mb85rs4mty = {
+    2000,
+    2000,
+    100,
+    {{0, 0, 0}, {OPCODE_DPD, 400, 2000}, {OPCODE_SLEEP, 450, 100}}};
+
+/// Cypress FM25V02
+static const fram_power_t _power_fm25v02 = {
+    2500, 2500, 150, {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}};
+
+/// Lapis MR45V064B
+static const fram_power_t _power_mr45v064b = {
+    2000, 2000, 50, {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}}};
+
 /// Supported flash devices
 const struct {
-  uint8_t manufID;    ///< Manufacture ID
-  uint16_t prodID;    ///< Product ID
-  uint32_t size;      ///< Size in bytes
-  bool support_sleep; ///< Support sleep mode
+  uint8_t manufID;           ///< Manufacture ID
+  uint16_t prodID;           ///< Product ID
+  uint32_t size;             ///< Size in bytes
+  const fram_power_t *power; ///< Currents and low-power modes
 } _supported_devices[] = {
     // Sorted in numerical order
     // Fujitsu
-    {0x04, 0x0101, 2 * 1024UL, false},  // MB85RS16
-    {0x04, 0x0302, 8 * 1024UL, false},  // MB85RS64V
-    {0x04, 0x2303, 8 * 1024UL, true},   // MB85RS64T
-    {0x04, 0x2503, 32 * 1024UL, true},  // MB85RS256TY
-    {0x04, 0x2703, 128 * 1024UL, true}, // MB85RS1MT
-    {0x04, 0x4803, 256 * 1024UL, true}, // MB85RS2MTA
-    {0x04, 0x2803, 256 * 1024UL, true}, // MB85RS2MT
-    {0x04, 0x4903, 512 * 1024UL, true}, // MB85RS4MT
-    {0x04, 0x490B, 512 * 1024UL, true}, // MB85RS4MTY
+    {0x04, 0x0101, 2 * 1024UL, &_power_mb85rs_v},     // MB85RS16
+    {0x04, 0x0302, 8 * 1024UL, &_power_mb85rs_v},     // MB85RS64V
+    {0x04, 0x2303, 8 * 1024UL, &_power_mb85rs_t},     // MB85RS64T
+    {0x04, 0x2503, 32 * 1024UL, &_power_mb85rs_t},    // MB85RS256TY
+    {0x04, 0x2703, 128 * 1024UL, &_power_mb85rs_t},   // MB85RS1MT
+    {0x04, 0x4803, 256 * 1024UL, &_power_mb85rs_t},   // MB85RS2MTA
+    {0x04, 0x2803, 256 * 1024UL, &_power_mb85rs_t},   // MB85RS2MT
+    {0x04, 0x4903, 512 * 1024UL, &_power_mb85rs_t},   // MB85RS4MT
+    {0x04, 0x490B, 512 * 1024UL, &_power_mb85rs4mty}, // MB85RS4MTY
 
     // Cypress
-    {0x7F, 0x7F7f, 32 * 1024UL, false}, // FM25V02
+    {0x7F, 0x7F7f, 32 * 1024UL, &_power_fm25v02}, // FM25V02
     // (manu = 7F7F7F7F7F7FC2, device = 0x2200)
 
     // Lapis
-    {0xAE, 0x8305, 8 * 1024UL, false} // MR45V064B
+    {0xAE, 0x8305, 8 * 1024UL, &_power_mr45v064b} // MR45V064B
 };
 
 /*!
@@ -89,6 +179,20 @@ static int get_supported_idx(uint8_t manufID, uint16_t prodID) {
 void Adafruit_FRAM_SPI::init(void) {
   _nAddressSizeBytes = 0;
   _dev_idx = -1;
+  _sleeping = false;
+  _lpMode = FRAM_LP_SLEEP;
+  _autoSleepMode = FRAM_LP_SLEEP;
+  _waking = false;
+  _wakeStart = 0;
+  _sleepSince = 0;
+  _lastActivity = 0;
+  _autoSleepMillis = 0;
+  memset(&_power, 0, sizeof(_power));
+  _stats = NULL;
+  _hist = NULL;
+  _trace = NULL;
+  _heatmap = NULL;
+  _changes = NULL;
 }
 
 /*!
@@ -193,12 +297,17 @@ bool Adafruit_FRAM_SPI::begin(uint8_t nAddressSizeBytes) {
 bool Adafruit_FRAM_SPI::writeEnable(bool enable) {
   uint8_t cmd;
 
+  ensureAwake();
+
   if (enable) {
     cmd = OPCODE_WREN;
   } else {
     cmd = OPCODE_WRDI;
   }
-  return spi_dev->write(&cmd, 1);
+  uint32_t start = opStart(cmd, 0, 0);
+  bool ok = spi_dev->write(&cmd, 1);
+  opEnd(FRAM_OP_CONTROL, cmd, 0, start, 1, 0, ok);
+  return ok;
 }
 
 /*!
@@ -213,6 +322,8 @@ bool Adafruit_FRAM_SPI::write8(uint32_t addr, uint8_t value) {
   uint8_t buffer[10];
   uint8_t i = 0;
 
+  ensureAwake();
+
   buffer[i++] = OPCODE_WRITE;
   if (_nAddressSizeBytes > 3) {
     buffer[i++] = (uint8_t)(addr >> 24);
@@ -224,11 +335,16 @@ bool Adafruit_FRAM_SPI::write8(uint32_t addr, uint8_t value) {
   buffer[i++] = (uint8_t)(addr & 0xFF);
   buffer[i++] = value;
 
-  return spi_dev->write(buffer, i);
+  uint32_t start = opStart(OPCODE_WRITE, addr, 1);
+  bool ok = spi_dev->write(buffer, i);
+  opEnd(FRAM_OP_WRITE8, OPCODE_WRITE, addr, start, i - 1, 1, ok);
+  return ok;
 }
 
 /*!
- *   @brief  Writes count bytes starting at the specific FRAM address
+ *   @brief  Writes count bytes starting at the specific FRAM address.
+ *           The part clears WEL at the end of every WRITE, so each call
+ *           needs its own writeEnable(true) and no WRDI afterwards.
  *   @param addr
  *           The 32-bit address to write to in FRAM memory
  *   @param values
@@ -242,6 +358,8 @@ bool Adafruit_FRAM_SPI::write(uint32_t addr, const uint8_t *values,
   uint8_t prebuf[10];
   uint8_t i = 0;
 
+  ensureAwake();
+
   prebuf[i++] = OPCODE_WRITE;
   if (_nAddressSizeBytes > 3) {
     prebuf[i++] = (uint8_t)(addr >> 24);
@@ -252,7 +370,10 @@ bool Adafruit_FRAM_SPI::write(uint32_t addr, const uint8_t *values,
   prebuf[i++] = (uint8_t)(addr >> 8);
   prebuf[i++] = (uint8_t)(addr & 0xFF);
 
-  return spi_dev->write(values, count, prebuf, i);
+  uint32_t start = opStart(OPCODE_WRITE, addr, count);
+  bool ok = spi_dev->write(values, count, prebuf, i);
+  opEnd(FRAM_OP_WRITE, OPCODE_WRITE, addr, start, i, count, ok);
+  return ok;
 }
 
 /*!
@@ -265,6 +386,8 @@ uint8_t Adafruit_FRAM_SPI::read8(uint32_t addr) {
   uint8_t buffer[10], val;
   uint8_t i = 0;
 
+  ensureAwake();
+
   buffer[i++] = OPCODE_READ;
   if (_nAddressSizeBytes > 3) {
     buffer[i++] = (uint8_t)(addr >> 24);
@@ -275,7 +398,9 @@ uint8_t Adafruit_FRAM_SPI::read8(uint32_t addr) {
   buffer[i++] = (uint8_t)(addr >> 8);
   buffer[i++] = (uint8_t)(addr & 0xFF);
 
-  spi_dev->write_then_read(buffer, i, &val, 1);
+  uint32_t start = opStart(OPCODE_READ, addr, 1);
+  bool ok = spi_dev->write_then_read(buffer, i, &val, 1);
+  opEnd(FRAM_OP_READ8, OPCODE_READ, addr, start, i, 1, ok);
 
   return val;
 }
@@ -294,6 +419,8 @@ bool Adafruit_FRAM_SPI::read(uint32_t addr, uint8_t *values, size_t count) {
   uint8_t buffer[10];
   uint8_t i = 0;
 
+  ensureAwake();
+
   buffer[i++] = OPCODE_READ;
   if (_nAddressSizeBytes > 3) {
     buffer[i++] = (uint8_t)(addr >> 24);
@@ -304,7 +431,10 @@ bool Adafruit_FRAM_SPI::read(uint32_t addr, uint8_t *values, size_t count) {
   buffer[i++] = (uint8_t)(addr >> 8);
   buffer[i++] = (uint8_t)(addr & 0xFF);
 
-  return spi_dev->write_then_read(buffer, i, values, count);
+  uint32_t start = opStart(OPCODE_READ, addr, count);
+  bool ok = spi_dev->write_then_read(buffer, i, values, count);
+  opEnd(FRAM_OP_READ, OPCODE_READ, addr, start, i, count, ok);
+  return ok;
 }
 
 /*!
@@ -322,7 +452,12 @@ bool Adafruit_FRAM_SPI::getDeviceID(uint8_t *manufacturerID,
   uint8_t cmd = OPCODE_RDID;
   uint8_t a[4] = {0, 0, 0, 0};
 
-  if (!spi_dev->write_then_read(&cmd, 1, a, 4)) {
+  ensureAwake();
+
+  uint32_t start = opStart(cmd, 0, 4);
+  bool ok = spi_dev->write_then_read(&cmd, 1, a, 4);
+  opEnd(FRAM_OP_CONTROL, cmd, 0, start, 1, 4, ok);
+  if (!ok) {
     return false;
   }
 
@@ -348,9 +483,13 @@ bool Adafruit_FRAM_SPI::getDeviceID(uint8_t *manufacturerID,
 uint8_t Adafruit_FRAM_SPI::getStatusRegister() {
   uint8_t cmd, val;
 
+  ensureAwake();
+
   cmd = OPCODE_RDSR;
 
-  spi_dev->write_then_read(&cmd, 1, &val, 1);
+  uint32_t start = opStart(cmd, 0, 1);
+  bool ok = spi_dev->write_then_read(&cmd, 1, &val, 1);
+  opEnd(FRAM_OP_STATUS, cmd, 0, start, 1, 1, ok);
 
   return val;
 }
@@ -364,10 +503,15 @@ uint8_t Adafruit_FRAM_SPI::getStatusRegister() {
 bool Adafruit_FRAM_SPI::setStatusRegister(uint8_t value) {
   uint8_t cmd[2];
 
+  ensureAwake();
+
   cmd[0] = OPCODE_WRSR;
   cmd[1] = value;
 
-  return spi_dev->write(cmd, 2);
+  uint32_t start = opStart(OPCODE_WRSR, 0, 1);
+  bool ok = spi_dev->write(cmd, 2);
+  opEnd(FRAM_OP_STATUS, OPCODE_WRSR, 0, start, 1, 1, ok);
+  return ok;
 }
 
 /*!
@@ -380,42 +524,555 @@ void Adafruit_FRAM_SPI::setAddressSize(uint8_t nAddressSize) {
 }
 
 /*!
- *  @brief  Enters the FRAM's low power sleep mode
+ *   @brief  Returns the capacity of the detected device
+ *   @return size in bytes, 0 if begin() has not identified the part
+ */
+uint32_t Adafruit_FRAM_SPI::getSize(void) {
+  if (_dev_idx == -1) {
+    return 0;
+  }
+  return _supported_devices[_dev_idx].size;
+}
+
+/*!
+ *  @brief  Enters the FRAM's low power sleep mode, i.e. the mode entered
+ *          with OPCODE_SLEEP (Hibernate on the MB85RS4MTY)
  *  @return true if successful
  */
 // WARNING: this method has not yet been validated
 bool Adafruit_FRAM_SPI::enterSleep(void) {
-  if (_dev_idx == -1 || !_supported_devices[_dev_idx].support_sleep) {
+  for (uint8_t m = 0; m < FRAM_LP_MODES; m++) {
+    if (hasLowPower((fram_lowpower_t)m) &&
+        _supported_devices[_dev_idx].power->lp_modes[m].opcode ==
+            OPCODE_SLEEP) {
+      return enterLowPower((fram_lowpower_t)m);
+    }
+  }
+  return false;
+}
+
+/*!
+ *  @brief  Typical operating current of the detected part
+ *  @param  write
+ *          true for the write current, false for the read current
+ *  @return Current in uA, 0 if begin() has not identified the part
+ */
+uint16_t Adafruit_FRAM_SPI::getActiveMicroamps(bool write) {
+  if (_dev_idx == -1) {
+    return 0;
+  }
+  const fram_power_t *power = _supported_devices[_dev_idx].power;
+  return write ? power->write_uA : power->read_uA;
+}
+
+/*!
+ *  @brief  Typical standby current (CS high) of the detected part
+ *  @return Current in uA, 0 if begin() has not identified the part
+ */
+uint16_t Adafruit_FRAM_SPI::getStandbyMicroamps(void) {
+  if (_dev_idx == -1) {
+    return 0;
+  }
+  return _supported_devices[_dev_idx].power->standby_uA;
+}
+
+/*!
+ *  @brief  Checks whether the detected part offers a low-power mode
+ *  @param  mode
+ *          Mode to check
+ *  @return true if the mode can be entered
+ */
+bool Adafruit_FRAM_SPI::hasLowPower(fram_lowpower_t mode) {
+  return _dev_idx != -1 && mode < FRAM_LP_MODES &&
+         _supported_devices[_dev_idx].power->lp_modes[mode].opcode;
+}
+
+/*!
+ *  @brief  Recovery time of a low-power mode
+ *  @param  mode
+ *          Mode to look up
+ *  @return tREC in us, 0 if the part lacks the mode
+ */
+uint16_t Adafruit_FRAM_SPI::getLowPowerWakeMicros(fram_lowpower_t mode) {
+  if (!hasLowPower(mode)) {
+    return 0;
+  }
+  return _supported_devices[_dev_idx].power->lp_modes[mode].wake_us;
+}
+
+/*!
+ *  @brief  Typical supply current in a low-power mode
+ *  @param  mode
+ *          Mode to look up
+ *  @return Current in nA, 0 if the part lacks the mode
+ */
+uint16_t Adafruit_FRAM_SPI::getLowPowerNanoamps(fram_lowpower_t mode) {
+  if (!hasLowPower(mode)) {
+    return 0;
+  }
+  return _supported_devices[_dev_idx].power->lp_modes[mode].current_nA;
+}
+
+/*!
+ *  @brief  Picks the deepest low-power mode whose recovery time fits a
+ *          wake latency budget
+ *  @param  maxWakeMicros
+ *          Longest acceptable tREC, in us
+ *  @param  mode
+ *          Receives the selected mode
+ *  @return true if some mode fits the budget
+ */
+bool Adafruit_FRAM_SPI::selectLowPower(uint32_t maxWakeMicros,
+                                       fram_lowpower_t *mode) {
+  for (int8_t m = FRAM_LP_MODES - 1; m >= 0; m--) {
+    if (hasLowPower((fram_lowpower_t)m) &&
+        getLowPowerWakeMicros((fram_lowpower_t)m) <= maxWakeMicros) {
+      if (mode) {
+        *mode = (fram_lowpower_t)m;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ *  @brief  Puts the device in a low-power mode. It wakes on the next
+ *          operation, or with startWake()/exitSleep().
+ *  @param  mode
+ *          Mode to enter
+ *  @return true if successful
+ */
+bool Adafruit_FRAM_SPI::enterLowPower(fram_lowpower_t mode) {
+  if (!hasLowPower(mode)) {
+    return false;
+  }
+
+  ensureAwake();
+
+  uint8_t cmd = _supported_devices[_dev_idx].power->lp_modes[mode].opcode;
+  uint32_t start = opStart(cmd, 0, 0);
+  bool ok = spi_dev->write(&cmd, 1);
+  opEnd(FRAM_OP_CONTROL, cmd, 0, start, 1, 0, ok);
+  if (ok) {
+    _sleeping = true;
+    _lpMode = mode;
+    _sleepSince = millis();
+    _power.sleeps++;
+  }
+  return ok;
+}
+
+/*!
+ *  @brief  Enters the deepest low-power mode that can be left within a
+ *          wake latency budget
+ *  @param  maxWakeMicros
+ *          Longest acceptable tREC, in us
+ *  @return true if a mode fit the budget and was entered
+ */
+bool Adafruit_FRAM_SPI::enterLowPowerWithin(uint32_t maxWakeMicros) {
+  fram_lowpower_t mode;
+  if (!selectLowPower(maxWakeMicros, &mode)) {
     return false;
   }
-  uint8_t cmd = OPCODE_SLEEP;
-  return spi_dev->write(&cmd, 1);
+  return enterLowPower(mode);
 }
 
 /*!
- *  @brief  exits the FRAM's low power sleep mode
+ *  @brief  exits the FRAM's low power sleep mode. Blocks only until tREC
+ *          has elapsed since the wake started; use startWake() and
+ *          isAwake() to avoid blocking at all.
  *  @return true if successful
  */
 // WARNING: this method has not yet been validated
 bool Adafruit_FRAM_SPI::exitSleep(void) {
-  if (_dev_idx == -1 || !_supported_devices[_dev_idx].support_sleep) {
+  fram_lowpower_t deepest = FRAM_LP_SLEEP;
+  if (!selectLowPower(0xFFFFFFFF, &deepest)) {
     return false;
   }
 
-  // Returning to a normal operation from the SLEEP mode is carried out after
-  // tREC (Max 400 μs) time from the falling edge of CS
+  // The device may have been put to sleep behind our back (e.g. before a
+  // reset), so always issue the wake pulse when asked explicitly
+  if (!_sleeping) {
+    _sleeping = true;
+    _lpMode = deepest;
+    _sleepSince = millis();
+  }
+
+  startWake();
+  ensureAwake();
+  return true;
+}
+
+/*!
+ *  @brief  Puts the device to sleep automatically once it has been idle for
+ *          the given time. update() must be called regularly (e.g. from
+ *          loop()) to apply the timeout; any operation issued while asleep
+ *          wakes the device first.
+ *  @param  idleMillis
+ *          Idle time before sleeping, in ms. 0 disables auto-sleep.
+ *  @param  maxWakeMicros
+ *          Wake latency budget; the deepest mode within it is used
+ *  @return true if a low-power mode fits the budget, or auto-sleep was
+ *          disabled
+ */
+bool Adafruit_FRAM_SPI::setAutoSleep(uint32_t idleMillis,
+                                     uint32_t maxWakeMicros) {
+  fram_lowpower_t mode = FRAM_LP_SLEEP;
+  if (idleMillis && !selectLowPower(maxWakeMicros, &mode)) {
+    return false;
+  }
+  _autoSleepMode = mode;
+  _autoSleepMillis = idleMillis;
+  _lastActivity = millis();
+  return true;
+}
+
+/*!
+ *  @brief  Applies the auto-sleep timeout. Cheap enough to call on every
+ *          pass through loop().
+ */
+void Adafruit_FRAM_SPI::update(void) {
+  if (_autoSleepMillis && !_sleeping &&
+      millis() - _lastActivity >= _autoSleepMillis) {
+    enterLowPower((fram_lowpower_t)_autoSleepMode);
+  }
+}
+
+/*!
+ *  @brief  Starts waking a sleeping device without waiting for it: CS is
+ *          pulsed and the time recorded, then control returns at once.
+ *          Poll isAwake() or wakeRemaining() to do other work during tREC;
+ *          any FRAM operation only waits for whatever part of tREC is left.
+ *          Does nothing if the device is awake or already waking.
+ */
+void Adafruit_FRAM_SPI::startWake(void) {
+  if (!_sleeping || _waking) {
+    return;
+  }
+
+  opStart(0, 0, 0);
+  // Recovery starts at the falling edge of CS. CS may go high again right
+  // away, but must not be brought low again until tREC has elapsed.
   spi_dev->beginTransactionWithAssertingCS();
-  delayMicroseconds(300);
-  // It is possible to return CS to H level before tREC time. However, it
-  // is prohibited to bring down CS to L level again during tREC period.
   spi_dev->endTransactionWithDeassertingCS();
-  delayMicroseconds(100);
+  _wakeStart = micros();
+  _waking = true;
+}
 
-  // MB85RS4MTY requires 450us (extra 50us) to wake from "Hibernate"
-  if (_supported_devices[_dev_idx].manufID == 0x04 &&
-      _supported_devices[_dev_idx].prodID == 0x0B) {
-    delayMicroseconds(50);
+/*!
+ *  @brief  Polls a wake started with startWake() without blocking
+ *  @return true once the device can take commands, false while it is
+ *          asleep or still within tREC
+ */
+bool Adafruit_FRAM_SPI::isAwake(void) {
+  if (!_sleeping) {
+    return true;
+  }
+  if (!_waking || (uint32_t)(micros() - _wakeStart) < wakeMicros()) {
+    return false;
+  }
+  ensureAwake();
+  return true;
+}
+
+/*!
+ *  @brief  Time left before the device can take commands
+ *  @return 0 when awake, the rest of tREC while waking, and the full tREC
+ *          while asleep with no wake started
+ */
+uint32_t Adafruit_FRAM_SPI::wakeRemaining(void) {
+  if (!_sleeping) {
+    return 0;
+  }
+  uint16_t trec = wakeMicros();
+  if (!_waking) {
+    return trec;
+  }
+  uint32_t elapsed = micros() - _wakeStart;
+  return elapsed >= trec ? 0 : trec - elapsed;
+}
+
+/*!
+ *  @brief  Copies the sleep bookkeeping. sleepMillis includes the current
+ *          sleep period, if any.
+ *  @param  stats
+ *          Destination
+ */
+void Adafruit_FRAM_SPI::getPowerStats(fram_spi_power_stats_t *stats) {
+  if (!stats) {
+    return;
+  }
+  *stats = _power;
+  if (_sleeping) {
+    accountSleep(stats);
+  }
+}
+
+/*!
+ *  @brief  Adds the current sleep period, up to now, to a power record
+ *  @param  power
+ *          Record to update
+ */
+void Adafruit_FRAM_SPI::accountSleep(fram_spi_power_stats_t *power) {
+  uint32_t slept = millis() - _sleepSince;
+  power->sleepMillis += slept;
+  power->modeMillis[_lpMode] += slept;
+}
+
+/*!
+ *  @brief  Recovery time from the low-power mode last entered
+ *  @return tREC in us
+ */
+uint16_t Adafruit_FRAM_SPI::wakeMicros(void) {
+  return getLowPowerWakeMicros((fram_lowpower_t)_lpMode);
+}
+
+/*!
+ *  @brief  Makes sure the device can take a command: starts a wake if it is
+ *          asleep and waits out the rest of tREC
+ */
+void Adafruit_FRAM_SPI::ensureAwake(void) {
+  if (!_sleeping) {
+    return;
   }
 
+  startWake();
+  uint32_t waited = micros();
+  uint16_t trec = wakeMicros();
+  while ((uint32_t)(micros() - _wakeStart) < trec) {
+    // busy-wait for the remainder of tREC only
+  }
+  _power.wakeWaitMicros += micros() - waited;
+  _power.wakes++;
+  accountSleep(&_power);
+
+  opEnd(FRAM_OP_WAKE, 0, 0, _wakeStart, 0, 0, true);
+  _sleeping = false;
+  _waking = false;
+}
+
+/*!
+ *  @brief  Attaches a statistics block that the driver updates on every
+ *          bus transfer. The block is owned by the caller and is not cleared
+ *          here, so counters can survive re-attachment.
+ *  @param  stats
+ *          Block to update, or NULL to stop collecting
+ */
+void Adafruit_FRAM_SPI::setStats(fram_spi_stats_t *stats) { _stats = stats; }
+
+/*!
+ *  @brief  Copies the attached statistics block
+ *  @param  snapshot
+ *          Destination for a consistent copy of the counters
+ *  @return true if a block is attached and statistics are compiled in
+ */
+bool Adafruit_FRAM_SPI::getStats(fram_spi_stats_t *snapshot) {
+#if FRAM_SPI_STATS
+  if (!_stats || !snapshot) {
+    return false;
+  }
+  noInterrupts();
+  memcpy(snapshot, _stats, sizeof(fram_spi_stats_t));
+  interrupts();
   return true;
+#else
+  (void)snapshot;
+  return false;
+#endif
+}
+
+/*!
+ *  @brief  Zeroes every counter in the attached statistics block
+ */
+void Adafruit_FRAM_SPI::resetStats(void) {
+#if FRAM_SPI_STATS
+  if (_stats) {
+    noInterrupts();
+    memset(_stats, 0, sizeof(fram_spi_stats_t));
+    interrupts();
+  }
+#endif
+}
+
+/*!
+ *  @brief  Attaches latency histograms that the driver feeds with the
+ *          duration of every read, write, status access and wake
+ *  @param  histogram
+ *          Histograms to update, or NULL to stop collecting
+ */
+void Adafruit_FRAM_SPI::setHistogram(Adafruit_FRAM_SPI_Histogram *histogram) {
+  _hist = histogram;
+}
+
+/*!
+ *  @brief  Attaches a trace recorder that logs every bus transfer
+ *  @param  trace
+ *          Recorder to feed, or NULL to stop tracing
+ */
+void Adafruit_FRAM_SPI::setTrace(Adafruit_FRAM_SPI_Trace *trace) {
+  _trace = trace;
+}
+
+/*!
+ *  @brief  Attaches an access heatmap that counts every read and write
+ *          against the address buckets it touches
+ *  @param  heatmap
+ *          Heatmap to update, or NULL to stop counting
+ */
+void Adafruit_FRAM_SPI::setHeatmap(Adafruit_FRAM_SPI_Heatmap *heatmap) {
+  _heatmap = heatmap;
+}
+
+/*!
+ *  @brief  Attaches a change tracker that stamps the blocks touched by
+ *          every write, for incremental replication. Unlike the
+ *          diagnostic hooks it is not affected by FRAM_SPI_STATS.
+ *  @param  changes
+ *          Tracker to update, or NULL to stop tracking
+ */
+void Adafruit_FRAM_SPI::setChanges(Adafruit_FRAM_SPI_Changes *changes) {
+  _changes = changes;
+}
+
+/*!
+ *  @brief  Marks the start of a bus transfer
+ *  @param  opcode
+ *          Opcode about to be sent, 0 for a wake pulse
+ *  @param  addr
+ *          Array address for read and write transfers, 0 otherwise
+ *  @param  length
+ *          Payload bytes about to be moved
+ *  @return Timestamp to hand back to opEnd(), 0 when nothing is collected
+ */
+uint32_t Adafruit_FRAM_SPI::opStart(uint8_t opcode, uint32_t addr,
+                                    size_t length) {
+#if FRAM_SPI_HOOKS
+  framSPIBeforeTransfer(this, opcode, addr, length);
+  return micros();
+#else
+  (void)opcode;
+  (void)addr;
+  (void)length;
+#endif
+#if FRAM_SPI_STATS
+  if (_stats || _hist || _trace) {
+    return micros();
+  }
+#endif
+  return 0;
+}
+
+/*!
+ *  @brief  Accounts for a finished bus transfer
+ *  @param  op
+ *          Operation class the transfer belongs to
+ *  @param  opcode
+ *          Opcode that framed the transfer, ignored for FRAM_OP_WAKE
+ *  @param  addr
+ *          Array address for read and write transfers, 0 otherwise
+ *  @param  start
+ *          Value returned by opStart()
+ *  @param  overhead
+ *          Opcode and address bytes sent
+ *  @param  payload
+ *          Data bytes sent or received
+ *  @param  ok
+ *          Result reported by the SPI layer
+ */
+void Adafruit_FRAM_SPI::opEnd(fram_op_t op, uint8_t opcode, uint32_t addr,
+                              uint32_t start, size_t overhead, size_t payload,
+                              bool ok) {
+  if (_autoSleepMillis) {
+    _lastActivity = millis();
+  }
+
+  if (_changes && ok && opcode == OPCODE_WRITE) {
+    _changes->record(addr, payload);
+  }
+
+#if FRAM_SPI_HOOKS
+  framSPIAfterTransfer(this, opcode, addr, payload, micros() - start, ok);
+#endif
+#if FRAM_SPI_STATS
+  if (_heatmap && ok && (opcode == OPCODE_READ || opcode == OPCODE_WRITE)) {
+    _heatmap->record(opcode == OPCODE_WRITE, addr, payload);
+  }
+
+  if (!_stats && !_hist && !_trace) {
+    return;
+  }
+
+  uint32_t elapsed = micros() - start;
+
+  if (_hist) {
+    _hist->record(op, elapsed);
+  }
+
+  if (_trace) {
+    _trace->record(start, op, opcode, addr, payload, ok);
+  }
+
+  if (!_stats) {
+    return;
+  }
+
+  _stats->opCounts[op]++;
+  _stats->opMicros[op] += elapsed;
+
+  // A wake is a CS pulse plus a wait for tREC, not a bus transfer
+  if (op == FRAM_OP_WAKE) {
+    _stats->wakes++;
+    _stats->wakeMicros += elapsed;
+    return;
+  }
+
+  uint8_t slot;
+  switch (opcode) {
+  case OPCODE_WREN:
+    slot = FRAM_STAT_WREN;
+    break;
+  case OPCODE_WRDI:
+    slot = FRAM_STAT_WRDI;
+    break;
+  case OPCODE_RDSR:
+    slot = FRAM_STAT_RDSR;
+    break;
+  case OPCODE_WRSR:
+    slot = FRAM_STAT_WRSR;
+    break;
+  case OPCODE_READ:
+    slot = FRAM_STAT_READ;
+    break;
+  case OPCODE_WRITE:
+    slot = FRAM_STAT_WRITE;
+    break;
+  case OPCODE_RDID:
+    slot = FRAM_STAT_RDID;
+    break;
+  default:
+    slot = FRAM_STAT_SLEEP;
+    if (ok) {
+      _stats->sleeps++;
+    }
+    break;
+  }
+  _stats->opcodes[slot]++;
+
+  _stats->overheadBytes += overhead;
+  _stats->payloadBytes += payload;
+  _stats->transactions++;
+  if (!ok) {
+    _stats->failures++;
+  }
+  _stats->busMicros += elapsed;
+#else
+  (void)op;
+  (void)opcode;
+  (void)addr;
+  (void)start;
+  (void)overhead;
+  (void)payload;
+  (void)ok;
+#endif
 }
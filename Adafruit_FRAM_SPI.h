@@ -26,18 +26,86 @@
 #include <Arduino.h>
 #include <SPI.h>
 
+#include "Adafruit_FRAM_SPI_Changes.h"
+#include "Adafruit_FRAM_SPI_Heatmap.h"
+#include "Adafruit_FRAM_SPI_Histogram.h"
+#include "Adafruit_FRAM_SPI_Trace.h"
+
 /** Operation Codes **/
 typedef enum opcodes_e {
-  OPCODE_WREN = 0b0110,     /* Write Enable Latch */
-  OPCODE_WRDI = 0b0100,     /* Reset Write Enable Latch */
-  OPCODE_RDSR = 0b0101,     /* Read Status Register */
-  OPCODE_WRSR = 0b0001,     /* Write Status Register */
-  OPCODE_READ = 0b0011,     /* Read Memory */
-  OPCODE_WRITE = 0b0010,    /* Write Memory */
-  OPCODE_RDID = 0b10011111, /* Read Device ID */
-  OPCODE_SLEEP = 0b10111001 /* Sleep Mode */
+  OPCODE_WREN = 0b0110,      /* Write Enable Latch */
+  OPCODE_WRDI = 0b0100,      /* Reset Write Enable Latch */
+  OPCODE_RDSR = 0b0101,      /* Read Status Register */
+  OPCODE_WRSR = 0b0001,      /* Write Status Register */
+  OPCODE_READ = 0b0011,      /* Read Memory */
+  OPCODE_WRITE = 0b0010,     /* Write Memory */
+  OPCODE_RDID = 0b10011111,  /* Read Device ID */
+  OPCODE_SLEEP = 0b10111001, /* Sleep Mode (Hibernate on MB85RS4MTY) */
+  OPCODE_DPD = 0b10111010    /* Deep Power-Down Mode */
 } opcodes_t;
 
+/** Low-power modes, from shallowest to deepest **/
+typedef enum fram_lowpower_e {
+  FRAM_LP_SLEEP,           /* Sleep */
+  FRAM_LP_DEEP_POWER_DOWN, /* Deep power-down */
+  FRAM_LP_HIBERNATE,       /* Hibernate */
+  FRAM_LP_MODES            /* Number of modes */
+} fram_lowpower_t;
+
+/// Set to 0 to compile the statistics, histogram, trace and heatmap hooks out
+#ifndef FRAM_SPI_STATS
+#define FRAM_SPI_STATS 1
+#endif
+
+/// Set to 1 to call framSPIBeforeTransfer()/framSPIAfterTransfer() around
+/// every bus transfer. Must be defined for the library build, e.g. with
+/// -DFRAM_SPI_HOOKS=1, so that the driver and the hooks agree.
+#ifndef FRAM_SPI_HOOKS
+#define FRAM_SPI_HOOKS 0
+#endif
+
+/** Slots of fram_spi_stats_t::opcodes, one per opcode **/
+typedef enum fram_stat_opcode_e {
+  FRAM_STAT_WREN,   /* OPCODE_WREN */
+  FRAM_STAT_WRDI,   /* OPCODE_WRDI */
+  FRAM_STAT_RDSR,   /* OPCODE_RDSR */
+  FRAM_STAT_WRSR,   /* OPCODE_WRSR */
+  FRAM_STAT_READ,   /* OPCODE_READ */
+  FRAM_STAT_WRITE,  /* OPCODE_WRITE */
+  FRAM_STAT_RDID,   /* OPCODE_RDID */
+  FRAM_STAT_SLEEP,  /* OPCODE_SLEEP and OPCODE_DPD */
+  FRAM_STAT_OPCODES /* Number of slots */
+} fram_stat_opcode_t;
+
+/*!
+ *  @brief  Bus I/O counters gathered by an Adafruit_FRAM_SPI instance.
+ *          All counters wrap silently at 2^32.
+ */
+typedef struct {
+  uint32_t opcodes[FRAM_STAT_OPCODES]; ///< Commands issued, per opcode
+  uint32_t payloadBytes;               ///< Data bytes moved to/from the array
+  uint32_t overheadBytes;              ///< Opcode and address bytes sent
+  uint32_t transactions;               ///< CS-framed transfers on the bus
+  uint32_t failures;                   ///< Transfers reported as failed
+  uint32_t wakes;                      ///< Transitions out of sleep mode
+  uint32_t sleeps;                     ///< Transitions into sleep mode
+  uint32_t busMicros;                  ///< Time spent in transfers, in us
+  uint32_t wakeMicros;                 ///< Time spent waiting out tREC, in us
+  uint32_t opCounts[FRAM_OP_CLASSES];  ///< Transfers, per fram_op_t
+  uint32_t opMicros[FRAM_OP_CLASSES];  ///< Time in transfers, per fram_op_t
+} fram_spi_stats_t;
+
+/*!
+ *  @brief  Sleep bookkeeping kept by every Adafruit_FRAM_SPI instance
+ */
+typedef struct {
+  uint32_t sleeps;         ///< Times the device was put to sleep
+  uint32_t wakes;          ///< Times the device was woken
+  uint32_t sleepMillis;    ///< Total time spent asleep, in ms
+  uint32_t wakeWaitMicros; ///< Time operations stalled waiting for tREC
+  uint32_t modeMillis[FRAM_LP_MODES]; ///< Time asleep, per fram_lowpower_t
+} fram_spi_power_stats_t;
+
 /*!
  *  @brief  Class that stores state and functions for interacting with
  *          FRAM SPI
@@ -59,14 +127,95 @@ public:
   uint8_t getStatusRegister(void);
   bool setStatusRegister(uint8_t value);
   void setAddressSize(uint8_t nAddressSize);
+  uint32_t getSize(void);
   bool enterSleep(void);
   bool exitSleep(void);
+  uint16_t getActiveMicroamps(bool write);
+  uint16_t getStandbyMicroamps(void);
+  bool hasLowPower(fram_lowpower_t mode);
+  uint16_t getLowPowerWakeMicros(fram_lowpower_t mode);
+  uint16_t getLowPowerNanoamps(fram_lowpower_t mode);
+  bool selectLowPower(uint32_t maxWakeMicros, fram_lowpower_t *mode);
+  bool enterLowPower(fram_lowpower_t mode);
+  bool enterLowPowerWithin(uint32_t maxWakeMicros);
+  bool setAutoSleep(uint32_t idleMillis, uint32_t maxWakeMicros = 0xFFFFFFFF);
+  void update(void);
+  void startWake(void);
+  bool isAwake(void);
+  uint32_t wakeRemaining(void);
+  void getPowerStats(fram_spi_power_stats_t *stats);
+
+  void setStats(fram_spi_stats_t *stats);
+  bool getStats(fram_spi_stats_t *snapshot);
+  void resetStats(void);
+  void setHistogram(Adafruit_FRAM_SPI_Histogram *histogram);
+  void setTrace(Adafruit_FRAM_SPI_Trace *trace);
+  void setHeatmap(Adafruit_FRAM_SPI_Heatmap *heatmap);
+  void setChanges(Adafruit_FRAM_SPI_Changes *changes);
 
 private:
   void init(void);
+  uint16_t wakeMicros(void);
+  void ensureAwake(void);
+  void accountSleep(fram_spi_power_stats_t *power);
+  uint32_t opStart(uint8_t opcode, uint32_t addr, size_t length);
+  void opEnd(fram_op_t op, uint8_t opcode, uint32_t addr, uint32_t start,
+             size_t overhead, size_t payload, bool ok);
   Adafruit_SPIDevice *spi_dev;
   uint8_t _nAddressSizeBytes;
   int _dev_idx;
+  bool _sleeping;
+  uint8_t _lpMode;
+  uint8_t _autoSleepMode;
+  bool _waking;
+  uint32_t _wakeStart;
+  uint32_t _sleepSince;
+  uint32_t _lastActivity;
+  uint32_t _autoSleepMillis;
+  fram_spi_power_stats_t _power;
+  fram_spi_stats_t *_stats;
+  Adafruit_FRAM_SPI_Histogram *_hist;
+  Adafruit_FRAM_SPI_Trace *_trace;
+  Adafruit_FRAM_SPI_Heatmap *_heatmap;
+  Adafruit_FRAM_SPI_Changes *_changes;
 };
 
+#if FRAM_SPI_HOOKS
+/*!
+ *  @brief  Called right before every bus transfer when FRAM_SPI_HOOKS is 1.
+ *          The library provides an empty weak default; define this function
+ *          in the sketch to attach profilers, GPIO markers or watchdog kicks.
+ *  @param  fram
+ *          Instance issuing the transfer
+ *  @param  opcode
+ *          Opcode about to be sent, 0 for a wake pulse
+ *  @param  addr
+ *          Array address, 0 for non-memory opcodes
+ *  @param  length
+ *          Payload bytes about to be moved
+ */
+void framSPIBeforeTransfer(Adafruit_FRAM_SPI *fram, uint8_t opcode,
+                           uint32_t addr, size_t length);
+
+/*!
+ *  @brief  Called right after every bus transfer when FRAM_SPI_HOOKS is 1.
+ *          Same linkage rules as framSPIBeforeTransfer().
+ *  @param  fram
+ *          Instance that issued the transfer
+ *  @param  opcode
+ *          Opcode sent, 0 for a wake pulse
+ *  @param  addr
+ *          Array address, 0 for non-memory opcodes
+ *  @param  length
+ *          Payload bytes moved
+ *  @param  duration
+ *          Time spent in the transfer, in us
+ *  @param  ok
+ *          Result reported by the SPI layer
+ */
+void framSPIAfterTransfer(Adafruit_FRAM_SPI *fram, uint8_t opcode,
+                          uint32_t addr, size_t length, uint32_t duration,
+                          bool ok);
+#endif
+
 #endif
@@ -0,0 +1,283 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Async.cpp
+ *
+ *  C++20 coroutine interface to Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Async.h"
+
+#ifdef FRAM_SPI_HAS_COROUTINE
+
+#if __has_include(<thread>)
+#include <thread>
+#define FRAM_SPI_YIELD() std::this_thread::yield()
+#else
+#define FRAM_SPI_YIELD()
+#endif
+
+/*!
+ *  @brief  Executor-side body of a status read
+ *  @param  fram
+ *          Device
+ *  @param  arg
+ *          uint8_t receiving the register
+ *  @return true
+ */
+static bool readStatus(Adafruit_FRAM_SPI &fram, void *arg) {
+  *(uint8_t *)arg = fram.getStatusRegister();
+  return true;
+}
+
+/*!
+ *  @brief  Executor-side body of a status write
+ *  @param  fram
+ *          Device
+ *  @param  arg
+ *          uint8_t holding the new register value
+ *  @return true on success
+ */
+static bool writeStatus(Adafruit_FRAM_SPI &fram, void *arg) {
+  return fram.writeEnable(true) && fram.setStatusRegister(*(uint8_t *)arg);
+}
+
+/*!
+ *  @brief  Awaitable read or write
+ *  @param  async
+ *          Executor resuming the awaiting coroutine
+ *  @param  op
+ *          FRAM_REQ_READ or FRAM_REQ_WRITE
+ *  @param  addr
+ *          FRAM address
+ *  @param  data
+ *          Buffer, kept alive by the awaiting coroutine
+ *  @param  len
+ *          Number of bytes
+ */
+Adafruit_FRAM_SPI_Op::Adafruit_FRAM_SPI_Op(Adafruit_FRAM_SPI_Async *async,
+                                           fram_spi_req_op_t op, uint32_t addr,
+                                           uint8_t *data, size_t len)
+    : _async(async), _next(NULL), _done(false), _value(0) {
+  _req.op = op;
+  _req.addr = addr;
+  _req.data = data;
+  _req.len = len;
+  _req.fn = NULL;
+  _req.arg = NULL;
+  _req.state.store(FRAM_REQ_IDLE, std::memory_order_relaxed);
+}
+
+/*!
+ *  @brief  Awaitable driver call
+ *  @param  async
+ *          Executor resuming the awaiting coroutine
+ *  @param  fn
+ *          Function run on the I/O side
+ *  @param  arg
+ *          Passed to fn, or NULL to pass a pointer to value
+ *  @param  value
+ *          Byte kept in the awaiter for fn
+ */
+Adafruit_FRAM_SPI_Op::Adafruit_FRAM_SPI_Op(
+    Adafruit_FRAM_SPI_Async *async, bool (*fn)(Adafruit_FRAM_SPI &, void *),
+    void *arg, uint8_t value)
+    : _async(async), _next(NULL), _done(false), _value(value) {
+  _req.op = FRAM_REQ_CALL;
+  _req.addr = 0;
+  _req.data = NULL;
+  _req.len = 0;
+  _req.fn = fn;
+  _req.arg = arg ? arg : &_value;
+  _req.state.store(FRAM_REQ_IDLE, std::memory_order_relaxed);
+}
+
+/*!
+ *  @brief  Parks the coroutine with the executor and queues the request
+ *  @param  h
+ *          Awaiting coroutine
+ */
+void Adafruit_FRAM_SPI_Op::await_suspend(std::coroutine_handle<> h) {
+  _handle = h;
+  _req.complete = completed;
+  _req.user = this;
+  _next = _async->_pending;
+  _async->_pending = this;
+  _async->_queue.submit(&_req);
+}
+
+/*!
+ *  @brief  Queue completion callback, on the I/O side. Marks the awaiter
+ *          ready; the executor may destroy it as soon as that is seen.
+ *  @param  req
+ *          Request of an Adafruit_FRAM_SPI_Op, user set to the awaiter
+ */
+void Adafruit_FRAM_SPI_Op::completed(fram_spi_request_t *req) {
+  Adafruit_FRAM_SPI_Op *op = static_cast<Adafruit_FRAM_SPI_Op *>(req->user);
+  Adafruit_FRAM_SPI_Async *async = op->_async;
+  op->_done.store(true, std::memory_order_release);
+  if (async->_wake) {
+    async->_wake(async->_wakeArg);
+  }
+}
+
+/*!
+ *  @brief  Creates an executor
+ *  @param  queue
+ *          Request queue in front of the device
+ *  @param  ownsIO
+ *          true if poll() should also run the queue; false when another
+ *          thread or task does
+ */
+Adafruit_FRAM_SPI_Async::Adafruit_FRAM_SPI_Async(Adafruit_FRAM_SPI_Queue &queue,
+                                                 bool ownsIO)
+    : _queue(queue) {
+  _ownsIO = ownsIO;
+  _pending = NULL;
+  _roots = NULL;
+  _wake = NULL;
+  _wakeArg = NULL;
+}
+
+/*!
+ *  @brief  Awaitable read
+ *  @param  addr
+ *          FRAM address
+ *  @param  buf
+ *          Destination, alive until resumed
+ *  @param  len
+ *          Number of bytes
+ *  @return Awaiter
+ */
+Adafruit_FRAM_SPI_Op Adafruit_FRAM_SPI_Async::read(uint32_t addr, uint8_t *buf,
+                                                   size_t len) {
+  return Adafruit_FRAM_SPI_Op(this, FRAM_REQ_READ, addr, buf, len);
+}
+
+/*!
+ *  @brief  Awaitable write, with its own WREN
+ *  @param  addr
+ *          FRAM address
+ *  @param  data
+ *          Data, alive until resumed
+ *  @param  len
+ *          Number of bytes
+ *  @return Awaiter
+ */
+Adafruit_FRAM_SPI_Op Adafruit_FRAM_SPI_Async::write(uint32_t addr,
+                                                    const uint8_t *data,
+                                                    size_t len) {
+  return Adafruit_FRAM_SPI_Op(this, FRAM_REQ_WRITE, addr, (uint8_t *)data,
+                              len);
+}
+
+/*!
+ *  @brief  Awaitable status register read
+ *  @param  value
+ *          Destination, alive until resumed
+ *  @return Awaiter
+ */
+Adafruit_FRAM_SPI_Op Adafruit_FRAM_SPI_Async::status(uint8_t *value) {
+  return Adafruit_FRAM_SPI_Op(this, readStatus, value);
+}
+
+/*!
+ *  @brief  Awaitable status register write
+ *  @param  value
+ *          New register value
+ *  @return Awaiter
+ */
+Adafruit_FRAM_SPI_Op Adafruit_FRAM_SPI_Async::setStatus(uint8_t value) {
+  return Adafruit_FRAM_SPI_Op(this, writeStatus, NULL, value);
+}
+
+/*!
+ *  @brief  Starts a task; it runs until its first bus operation and is
+ *          destroyed by poll() once finished
+ *  @param  task
+ *          Task to own
+ */
+void Adafruit_FRAM_SPI_Async::spawn(Adafruit_FRAM_SPI_Task<void> task) {
+  std::coroutine_handle<Adafruit_FRAM_SPI_Task<void>::promise_type> h =
+      task.release();
+  if (!h) {
+    return;
+  }
+  h.promise().self = h;
+  h.promise().nextRoot = _roots;
+  _roots = &h.promise();
+  h.resume();
+}
+
+/*!
+ *  @brief  One executor step: runs queued requests if the executor owns
+ *          the bus, resumes every coroutine whose request finished and
+ *          destroys finished spawned tasks. Call from one thread only.
+ *  @return Number of coroutines resumed
+ */
+uint32_t Adafruit_FRAM_SPI_Async::poll(void) {
+  if (_ownsIO) {
+    _queue.poll();
+  }
+
+  // Resuming may park new awaiters, so work from a detached list
+  uint32_t resumed = 0;
+  Adafruit_FRAM_SPI_Op *op = _pending;
+  _pending = NULL;
+  while (op) {
+    Adafruit_FRAM_SPI_Op *next = op->_next;
+    if (op->_done.load(std::memory_order_acquire)) {
+      op->_handle.resume();
+      resumed++;
+    } else {
+      op->_next = _pending;
+      _pending = op;
+    }
+    op = next;
+  }
+
+  fram_async_promise_base **link = &_roots;
+  while (*link) {
+    fram_async_promise_base *root = *link;
+    if (root->self.done()) {
+      *link = root->nextRoot;
+      root->self.destroy();
+    } else {
+      link = &root->nextRoot;
+    }
+  }
+  return resumed;
+}
+
+/*!
+ *  @brief  Polls until every spawned task has finished, yielding while
+ *          waiting on another I/O thread
+ */
+void Adafruit_FRAM_SPI_Async::run(void) {
+  while (!idle()) {
+    if (!poll()) {
+      FRAM_SPI_YIELD();
+    }
+  }
+}
+
+/*!
+ *  @brief  Whether every spawned task has finished and been reaped
+ *  @return true if there is nothing left to run
+ */
+bool Adafruit_FRAM_SPI_Async::idle(void) const { return _roots == NULL; }
+
+/*!
+ *  @brief  Sets a function called from the I/O side each time a request
+ *          finishes, e.g. to signal an event loop that should call poll()
+ *  @param  fn
+ *          Wake function, NULL for none
+ *  @param  arg
+ *          Passed to fn
+ */
+void Adafruit_FRAM_SPI_Async::setWakeup(void (*fn)(void *), void *arg) {
+  _wake = fn;
+  _wakeArg = arg;
+}
+
+#endif
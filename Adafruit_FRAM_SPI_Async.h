@@ -0,0 +1,291 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Async.h
+ *
+ *  C++20 coroutine interface to Adafruit_FRAM_SPI, layered on the
+ *  Adafruit_FRAM_SPI_Queue request queue. Only built where the compiler
+ *  implements coroutines and the queue is available.
+ *
+ *  A multi-step operation reads as straight-line code:
+ *
+ *    Adafruit_FRAM_SPI_Task<bool> append(Adafruit_FRAM_SPI_Async &io) {
+ *      uint8_t hdr[4];
+ *      bool ok = co_await io.read(0, hdr, sizeof(hdr));
+ *      if (!ok)
+ *        co_return false;
+ *      ...
+ *      co_return co_await io.write(addr, rec, sizeof(rec));
+ *    }
+ *
+ *    Adafruit_FRAM_SPI_Task<> logger(Adafruit_FRAM_SPI_Async &io) {
+ *      bool ok = co_await append(io);
+ *      if (!ok)
+ *        Serial.println("append failed");
+ *    }
+ *
+ *    io.spawn(logger(io));
+ *    io.run();
+ *
+ *  Keep co_await out of if, while and switch conditions, as above: GCC 12
+ *  can compile a coroutine with such a condition into one that never runs
+ *  its body, whatever is awaited.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_ASYNC_H_
+#define _ADAFRUIT_FRAM_SPI_ASYNC_H_
+
+#include "Adafruit_FRAM_SPI_Queue.h"
+
+#if defined(FRAM_SPI_HAS_ATOMIC) && defined(__cpp_impl_coroutine)
+#if __has_include(<coroutine>)
+#define FRAM_SPI_HAS_COROUTINE 1
+#endif
+#endif
+
+#ifdef FRAM_SPI_HAS_COROUTINE
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+class Adafruit_FRAM_SPI_Async;
+
+/*!
+ *  @brief  Promise state shared by every task type
+ */
+struct fram_async_promise_base {
+  std::coroutine_handle<> continuation; ///< Awaiting task, resumed at end
+  std::coroutine_handle<> self;         ///< Set while owned by the executor
+  fram_async_promise_base *nextRoot;    ///< Executor root list link
+
+  /*!
+   *  @brief  Final suspend point: hands control to the awaiting task, or
+   *          parks until the executor reaps a spawned task
+   */
+  struct final_awaiter {
+    /*!
+     *  @brief  Always suspends
+     *  @return false
+     */
+    bool await_ready() noexcept { return false; }
+    /*!
+     *  @brief  Picks the coroutine to run next
+     *  @param  h
+     *          Finishing coroutine
+     *  @return Its continuation, or a no-op handle
+     */
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+      std::coroutine_handle<> c = h.promise().continuation;
+      return c ? c : std::noop_coroutine();
+    }
+    /*!
+     *  @brief  Never resumed
+     */
+    void await_resume() noexcept {}
+  };
+
+  /*!
+   *  @brief  Tasks start when awaited or spawned
+   *  @return Suspend
+   */
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  /*!
+   *  @brief  Continues the awaiting task when the body ends
+   *  @return Final awaiter
+   */
+  final_awaiter final_suspend() noexcept { return {}; }
+  /*!
+   *  @brief  Exceptions are not supported on the targets this runs on
+   */
+  void unhandled_exception() noexcept { std::terminate(); }
+};
+
+/*!
+ *  @brief  Holds a task's co_return value
+ */
+template <typename T> struct fram_async_result {
+  T value; ///< Returned value
+
+  /*!
+   *  @brief  Stores the co_return value
+   *  @param  v
+   *          Value
+   */
+  void return_value(T v) { value = std::move(v); }
+  /*!
+   *  @brief  Moves the value out
+   *  @return Value
+   */
+  T take(void) { return std::move(value); }
+};
+
+/*!
+ *  @brief  Result holder for tasks without a value
+ */
+template <> struct fram_async_result<void> {
+  /*!
+   *  @brief  Handles co_return;
+   */
+  void return_void(void) {}
+  /*!
+   *  @brief  Nothing to move out
+   */
+  void take(void) {}
+};
+
+/*!
+ *  @brief  Lazily started coroutine returning T. co_await it from another
+ *          task, or hand a Task<void> to Adafruit_FRAM_SPI_Async::spawn().
+ */
+template <typename T = void> class Adafruit_FRAM_SPI_Task {
+public:
+  /*!
+   *  @brief  Coroutine promise
+   */
+  struct promise_type : fram_async_promise_base, fram_async_result<T> {
+    /*!
+     *  @brief  Wraps the new coroutine
+     *  @return Owning task
+     */
+    Adafruit_FRAM_SPI_Task get_return_object() {
+      return Adafruit_FRAM_SPI_Task(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+  };
+
+  /*!
+   *  @brief  Takes ownership of a coroutine
+   *  @param  h
+   *          Handle
+   */
+  explicit Adafruit_FRAM_SPI_Task(std::coroutine_handle<promise_type> h)
+      : _h(h) {}
+  /*!
+   *  @brief  Moves ownership
+   *  @param  other
+   *          Task left empty
+   */
+  Adafruit_FRAM_SPI_Task(Adafruit_FRAM_SPI_Task &&other) noexcept
+      : _h(std::exchange(other._h, nullptr)) {}
+  Adafruit_FRAM_SPI_Task(const Adafruit_FRAM_SPI_Task &) = delete;
+  Adafruit_FRAM_SPI_Task &operator=(const Adafruit_FRAM_SPI_Task &) = delete;
+  /*!
+   *  @brief  Destroys the coroutine if still owned
+   */
+  ~Adafruit_FRAM_SPI_Task() {
+    if (_h) {
+      _h.destroy();
+    }
+  }
+
+  /*!
+   *  @brief  Gives up ownership, used by spawn()
+   *  @return Handle
+   */
+  std::coroutine_handle<promise_type> release(void) {
+    return std::exchange(_h, nullptr);
+  }
+
+  /*!
+   *  @brief  Ready if already finished
+   *  @return true if there is nothing to run
+   */
+  bool await_ready() const noexcept { return !_h || _h.done(); }
+  /*!
+   *  @brief  Starts the task, resuming the awaiter when it finishes
+   *  @param  awaiter
+   *          Awaiting coroutine
+   *  @return Task to run next
+   */
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+    _h.promise().continuation = awaiter;
+    return _h;
+  }
+  /*!
+   *  @brief  Result of the task
+   *  @return co_return value
+   */
+  T await_resume() { return _h.promise().take(); }
+
+private:
+  std::coroutine_handle<promise_type> _h;
+};
+
+/*!
+ *  @brief  Awaitable bus operation; co_await yields true on success. The
+ *          request lives inside the awaiter, so nothing is allocated.
+ */
+class Adafruit_FRAM_SPI_Op {
+public:
+  Adafruit_FRAM_SPI_Op(Adafruit_FRAM_SPI_Async *async, fram_spi_req_op_t op,
+                       uint32_t addr, uint8_t *data, size_t len);
+  Adafruit_FRAM_SPI_Op(Adafruit_FRAM_SPI_Async *async,
+                       bool (*fn)(Adafruit_FRAM_SPI &, void *), void *arg,
+                       uint8_t value = 0);
+  Adafruit_FRAM_SPI_Op(const Adafruit_FRAM_SPI_Op &) = delete;
+
+  /*!
+   *  @brief  Always goes through the queue
+   *  @return false
+   */
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> h);
+  /*!
+   *  @brief  Result of the operation
+   *  @return true on success
+   */
+  bool await_resume() const noexcept { return _req.ok; }
+
+private:
+  friend class Adafruit_FRAM_SPI_Async;
+  static void completed(fram_spi_request_t *req);
+
+  fram_spi_request_t _req; // user points back at this awaiter
+  Adafruit_FRAM_SPI_Async *_async;
+  std::coroutine_handle<> _handle;
+  Adafruit_FRAM_SPI_Op *_next;
+  std::atomic<bool> _done;
+  uint8_t _value;
+};
+
+/*!
+ *  @brief  Minimal single-threaded executor for FRAM coroutines.
+ *
+ *          On an MCU the executor also owns the bus: poll() runs queued
+ *          requests and then resumes the coroutines they completed. On a
+ *          host or RTOS build pass ownsIO = false and run the queue's
+ *          poll() in a dedicated I/O thread, so transfers overlap with
+ *          coroutine computation; setWakeup() lets an event loop sleep
+ *          until a request finishes and then call poll().
+ */
+class Adafruit_FRAM_SPI_Async {
+public:
+  Adafruit_FRAM_SPI_Async(Adafruit_FRAM_SPI_Queue &queue, bool ownsIO = true);
+
+  Adafruit_FRAM_SPI_Op read(uint32_t addr, uint8_t *buf, size_t len);
+  Adafruit_FRAM_SPI_Op write(uint32_t addr, const uint8_t *data, size_t len);
+  Adafruit_FRAM_SPI_Op status(uint8_t *value);
+  Adafruit_FRAM_SPI_Op setStatus(uint8_t value);
+
+  void spawn(Adafruit_FRAM_SPI_Task<void> task);
+  uint32_t poll(void);
+  void run(void);
+  bool idle(void) const;
+  void setWakeup(void (*fn)(void *), void *arg);
+
+private:
+  friend class Adafruit_FRAM_SPI_Op;
+
+  Adafruit_FRAM_SPI_Queue &_queue;
+  bool _ownsIO;
+  Adafruit_FRAM_SPI_Op *_pending;  // Suspended on a request
+  fram_async_promise_base *_roots; // Spawned tasks
+  void (*_wake)(void *);
+  void *_wakeArg;
+};
+
+#endif
+
+#endif
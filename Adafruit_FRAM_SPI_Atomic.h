@@ -0,0 +1,53 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Atomic.h
+ *
+ *  Counter helpers shared by the FRAM SPI instrumentation. Updates are safe
+ *  against interrupts on every core and against other threads where the
+ *  toolchain provides lock-free atomics.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_ATOMIC_H_
+#define _ADAFRUIT_FRAM_SPI_ATOMIC_H_
+
+#include <Arduino.h>
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+/// Runs the following block with interrupts off, restoring the prior state
+#define FRAM_SPI_CRITICAL ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#elif (__GCC_ATOMIC_SHORT_LOCK_FREE == 2) && (__GCC_ATOMIC_INT_LOCK_FREE == 2)
+/// Counters are updated with lock-free compare-and-swap
+#define FRAM_SPI_LOCK_FREE 1
+#else
+/// Runs the following block with interrupts off. Cores without lock-free
+/// atomics (e.g. Cortex-M0) have no nesting-safe primitive in the Arduino
+/// API, so the block must not be entered with interrupts already masked.
+#define FRAM_SPI_CRITICAL                                                     \
+  for (uint8_t _fram_once = (noInterrupts(), 1); _fram_once;                 \
+       _fram_once = (interrupts(), 0))
+#endif
+
+/*!
+ *  @brief  Increments a 16-bit counter, sticking at 0xFFFF
+ *  @param  counter
+ *          Counter to bump
+ */
+static inline void fram_spi_inc16_sat(volatile uint16_t *counter) {
+#if defined(FRAM_SPI_LOCK_FREE)
+  uint16_t old = __atomic_load_n(counter, __ATOMIC_RELAXED);
+  while (old != 0xFFFF &&
+         !__atomic_compare_exchange_n(counter, &old, (uint16_t)(old + 1), true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+#else
+  FRAM_SPI_CRITICAL {
+    if (*counter != 0xFFFF) {
+      *counter = *counter + 1;
+    }
+  }
+#endif
+}
+
+#endif
@@ -0,0 +1,37 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_CRC.h
+ *
+ *  CRC-16/CCITT shared by the on-FRAM formats (staging log, WAL, deltas,
+ *  partition table). Internal to the library.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_CRC_H_
+#define _ADAFRUIT_FRAM_SPI_CRC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ *  @brief  CRC-16/CCITT (polynomial 0x1021), chainable across buffers;
+ *          unlike a Fletcher sum it tells 0x00 from 0xFF
+ *  @param  crc
+ *          0xFFFF to start, or the result for the preceding bytes
+ *  @param  data
+ *          Bytes to add
+ *  @param  len
+ *          Number of bytes
+ *  @return Updated CRC
+ */
+static inline uint16_t crc16(uint16_t crc, const uint8_t *data, size_t len) {
+  while (len--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+#endif
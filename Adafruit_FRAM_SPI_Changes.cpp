@@ -0,0 +1,259 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Changes.cpp
+ *
+ *  Change tracking and delta replication for Adafruit_FRAM_SPI.
+ *
+ *  Delta format, little-endian: a 12-byte header {'F', 'D', version,
+ *  blockShift, since, to}, then runs {addr, len(16), CRC-16 of addr and
+ *  len, data, CRC-16 of data} of at most FRAM_DELTA_MAX_RUN bytes, closed
+ *  by {run count, 0, CRC-16} with no data.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Changes.h"
+#include "Adafruit_FRAM_SPI.h"
+#include "Adafruit_FRAM_SPI_CRC.h"
+
+/// Delta stream format version
+#define FRAM_DELTA_VERSION 1
+
+#if FRAM_DELTA_MAX_RUN < 1 || FRAM_DELTA_MAX_RUN > 0x8000
+#error "FRAM_DELTA_MAX_RUN must be between 1 and 32768"
+#endif
+
+static void put32(uint8_t *buf, uint32_t value) {
+  buf[0] = (uint8_t)(value & 0xFF);
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *buf) {
+  return buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+/*!
+ *  @brief  Creates a change tracker over caller-owned storage
+ *  @param  seqs
+ *          One sequence number per block, see FRAM_CHANGES_BLOCKS()
+ *  @param  length
+ *          Number of entries in seqs
+ */
+Adafruit_FRAM_SPI_Changes::Adafruit_FRAM_SPI_Changes(uint32_t *seqs,
+                                                     uint32_t length)
+    : _seqs(seqs), _length(seqs ? length : 0) {
+  _blocks = 0;
+  _capacity = 0;
+  _seq = 0;
+  _shift = 8;
+}
+
+/*!
+ *  @brief  Sizes the block map. Every block starts out changed at
+ *          sequence 1, so a delta since 0 is a full image for a new mirror.
+ *  @param  capacity
+ *          Device size in bytes, e.g. Adafruit_FRAM_SPI::getSize()
+ *  @param  blockShift
+ *          log2 of the block size in bytes
+ *  @return false if the sequence array is too short
+ */
+bool Adafruit_FRAM_SPI_Changes::begin(uint32_t capacity, uint8_t blockShift) {
+  if (blockShift > 15) {
+    return false;
+  }
+  uint32_t blocks = FRAM_CHANGES_BLOCKS(capacity, blockShift);
+  if (!capacity || blocks > _length) {
+    _blocks = 0;
+    return false;
+  }
+  _shift = blockShift;
+  _capacity = capacity;
+  _blocks = blocks;
+  _seq = 1;
+  for (uint32_t i = 0; i < _blocks; i++) {
+    _seqs[i] = 1;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Stamps the blocks a write touched with a new sequence number.
+ *          Called by Adafruit_FRAM_SPI after each successful write.
+ *  @param  addr
+ *          First byte written
+ *  @param  length
+ *          Number of bytes written
+ */
+void Adafruit_FRAM_SPI_Changes::record(uint32_t addr, uint32_t length) {
+  if (!_blocks || !length || addr >= _capacity) {
+    return;
+  }
+  uint32_t first = addr >> _shift;
+  uint32_t last = (addr + length - 1) >> _shift;
+  if (last >= _blocks) {
+    last = _blocks - 1;
+  }
+  _seq++;
+  for (uint32_t b = first; b <= last; b++) {
+    _seqs[b] = _seq;
+  }
+}
+
+/*!
+ *  @brief  Latest sequence number handed out
+ *  @return Sequence number; a delta since it is empty
+ */
+uint32_t Adafruit_FRAM_SPI_Changes::sequence(void) const { return _seq; }
+
+/*!
+ *  @brief  Counts blocks changed after a sequence number
+ *  @param  since
+ *          Sequence number the mirror is at
+ *  @return Number of blocks a delta would carry
+ */
+uint32_t Adafruit_FRAM_SPI_Changes::changed(uint32_t since) const {
+  uint32_t n = 0;
+  for (uint32_t b = 0; b < _blocks; b++) {
+    if (_seqs[b] > since) {
+      n++;
+    }
+  }
+  return n;
+}
+
+/*!
+ *  @brief  Writes a run header {addr, len, CRC-16 of both}
+ *  @param  out
+ *          Destination
+ *  @param  addr
+ *          First byte of the run, or the run count for the closing run
+ *  @param  len
+ *          Run length, 0 for the closing run
+ *  @return Bytes written
+ */
+static size_t writeRunHeader(Print &out, uint32_t addr, uint16_t len) {
+  uint8_t hdr[8];
+  put32(hdr, addr);
+  hdr[4] = (uint8_t)(len & 0xFF);
+  hdr[5] = (uint8_t)(len >> 8);
+  uint16_t crc = crc16(0xFFFF, hdr, 6);
+  hdr[6] = (uint8_t)(crc & 0xFF);
+  hdr[7] = (uint8_t)(crc >> 8);
+  return out.write(hdr, sizeof(hdr));
+}
+
+/*!
+ *  @brief  Streams the blocks changed after a sequence number, with runs
+ *          of adjacent changed blocks merged, e.g. to Serial
+ *  @param  fram
+ *          Device being tracked
+ *  @param  since
+ *          Sequence number the mirror is at, 0 for everything
+ *  @param  out
+ *          Destination
+ *  @return Bytes written, 0 if the tracker is not begun or the device
+ *          could not be read
+ */
+size_t Adafruit_FRAM_SPI_Changes::writeDelta(Adafruit_FRAM_SPI &fram,
+                                             uint32_t since, Print &out) {
+  if (!_blocks) {
+    return 0;
+  }
+  uint8_t buf[32];
+  buf[0] = 'F';
+  buf[1] = 'D';
+  buf[2] = FRAM_DELTA_VERSION;
+  buf[3] = _shift;
+  put32(buf + 4, since);
+  put32(buf + 8, _seq);
+  size_t n = out.write(buf, 12);
+
+  uint32_t runs = 0;
+  for (uint32_t b = 0; b < _blocks;) {
+    if (_seqs[b] <= since) {
+      b++;
+      continue;
+    }
+    uint32_t addr = b << _shift;
+    while (b < _blocks && _seqs[b] > since) {
+      b++;
+    }
+    uint32_t end = b < _blocks ? b << _shift : _capacity;
+
+    // Cut the extent into runs the mirror can verify before writing
+    while (addr < end) {
+      uint16_t len = end - addr < FRAM_DELTA_MAX_RUN ? end - addr
+                                                     : FRAM_DELTA_MAX_RUN;
+      n += writeRunHeader(out, addr, len);
+      uint16_t crc = 0xFFFF;
+      for (uint16_t left = len; left;) {
+        uint16_t k = left < sizeof(buf) ? left : sizeof(buf);
+        if (!fram.read(addr, buf, k)) {
+          return 0;
+        }
+        crc = crc16(crc, buf, k);
+        n += out.write(buf, k);
+        addr += k;
+        left -= k;
+      }
+      buf[0] = (uint8_t)(crc & 0xFF);
+      buf[1] = (uint8_t)(crc >> 8);
+      n += out.write(buf, 2);
+      runs++;
+    }
+  }
+  return n + writeRunHeader(out, runs, 0);
+}
+
+/*!
+ *  @brief  Replays a delta from writeDelta() into a mirror FRAM. Each run
+ *          is checked (header CRC, bounds, data CRC) in RAM before it is
+ *          written, so a corrupted stream never writes outside the runs
+ *          it carries. A failure part way through can leave earlier runs
+ *          applied; the mirror stays at its old sequence number and the
+ *          next delta from there rewrites them.
+ *  @param  fram
+ *          Mirror device, already begun
+ *  @param  in
+ *          Source of the delta; reads use the stream's timeout
+ *  @param  at
+ *          Sequence number the mirror is at. The delta must start there,
+ *          unless it is a full image (since 0).
+ *  @return Sequence number the mirror is now at, 0 on error
+ */
+uint32_t Adafruit_FRAM_SPI_Changes::applyDelta(Adafruit_FRAM_SPI &fram,
+                                               Stream &in, uint32_t at) {
+  uint8_t buf[FRAM_DELTA_MAX_RUN];
+  if (in.readBytes(buf, 12) != 12 || buf[0] != 'F' || buf[1] != 'D' ||
+      buf[2] != FRAM_DELTA_VERSION) {
+    return 0;
+  }
+  uint32_t since = get32(buf + 4);
+  uint32_t to = get32(buf + 8);
+  if (since && since != at) {
+    return 0;
+  }
+
+  uint32_t capacity = fram.getSize();
+  for (uint32_t runs = 0;; runs++) {
+    uint8_t hdr[8];
+    if (in.readBytes(hdr, sizeof(hdr)) != sizeof(hdr) ||
+        (hdr[6] | (hdr[7] << 8)) != crc16(0xFFFF, hdr, 6)) {
+      return 0;
+    }
+    uint32_t addr = get32(hdr);
+    uint16_t len = hdr[4] | (hdr[5] << 8);
+    if (!len) {
+      return addr == runs ? to : 0;
+    }
+    if (len > FRAM_DELTA_MAX_RUN || addr > capacity ||
+        len > capacity - addr || in.readBytes(buf, len) != len ||
+        in.readBytes(hdr, 2) != 2 ||
+        (hdr[0] | (hdr[1] << 8)) != crc16(0xFFFF, buf, len) ||
+        !fram.writeEnable(true) || !fram.write(addr, buf, len)) {
+      return 0;
+    }
+  }
+}
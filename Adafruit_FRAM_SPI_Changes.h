@@ -0,0 +1,61 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Changes.h
+ *
+ *  Change tracking and delta replication for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_CHANGES_H_
+#define _ADAFRUIT_FRAM_SPI_CHANGES_H_
+
+#include <Arduino.h>
+
+class Adafruit_FRAM_SPI;
+
+/// Sequence array length needed for a device of size bytes cut into
+/// 2^shift byte blocks
+#define FRAM_CHANGES_BLOCKS(size, shift)                                       \
+  (((uint32_t)(size) + (1UL << (shift)) - 1) >> (shift))
+
+#ifndef FRAM_DELTA_MAX_RUN
+/// Longest run in a delta. applyDelta() verifies each run in a stack
+/// buffer this size before writing it, so both ends must agree on it.
+#define FRAM_DELTA_MAX_RUN 256
+#endif
+
+/*!
+ *  @brief  Tracks which blocks of an FRAM changed, for incremental
+ *          replication to a mirror device or host. Attached with
+ *          Adafruit_FRAM_SPI::setChanges(), it stamps every block a write
+ *          touches with a new sequence number. writeDelta() streams the
+ *          blocks changed after a given sequence number, merged into runs,
+ *          and applyDelta() replays such a stream into another FRAM. The
+ *          mirror keeps the returned sequence number and asks for the next
+ *          delta from there; a failed apply leaves it at the old number,
+ *          and the next delta from there repairs any runs already written.
+ */
+class Adafruit_FRAM_SPI_Changes {
+public:
+  Adafruit_FRAM_SPI_Changes(uint32_t *seqs, uint32_t length);
+
+  bool begin(uint32_t capacity, uint8_t blockShift = 8);
+  void record(uint32_t addr, uint32_t length);
+
+  uint32_t sequence(void) const;
+  uint32_t changed(uint32_t since) const;
+
+  size_t writeDelta(Adafruit_FRAM_SPI &fram, uint32_t since, Print &out);
+  static uint32_t applyDelta(Adafruit_FRAM_SPI &fram, Stream &in,
+                             uint32_t at);
+
+private:
+  uint32_t *_seqs;
+  uint32_t _length;
+  uint32_t _blocks;
+  uint32_t _capacity;
+  uint32_t _seq;
+  uint8_t _shift;
+};
+
+#endif
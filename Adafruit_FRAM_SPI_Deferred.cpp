@@ -0,0 +1,182 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Deferred.cpp
+ *
+ *  ISR-safe deferred write queue for Adafruit_FRAM_SPI.
+ *
+ *  The ring indices are single bytes so every load and store of them is
+ *  atomic, even on AVR. A barrier orders the payload copy against the
+ *  index update on both sides; __sync_synchronize() is a compiler barrier
+ *  on single-core parts and a hardware fence on dual-core ones.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Deferred.h"
+
+#if defined(__GNUC__)
+#define FRAM_DEFERRED_BARRIER() __sync_synchronize()
+#else
+#define FRAM_DEFERRED_BARRIER()
+#endif
+
+/*!
+ *  @brief  Reads a counter owned by the other side without tearing it on
+ *          8-bit cores
+ *  @param  v
+ *          Counter
+ *  @return Its value
+ */
+static uint32_t stable(const volatile uint32_t &v) {
+  uint32_t a;
+  do {
+    a = v;
+  } while (a != v);
+  return a;
+}
+
+/*!
+ *  @brief  Creates a queue over caller-owned storage
+ *  @param  fram
+ *          Device drained into
+ *  @param  entries
+ *          Ring storage, typically a static array
+ *  @param  capacity
+ *          Number of entries in the array, 2 to 255
+ */
+Adafruit_FRAM_SPI_Deferred::Adafruit_FRAM_SPI_Deferred(
+    Adafruit_FRAM_SPI &fram, fram_deferred_entry_t *entries, uint8_t capacity)
+    : _fram(fram) {
+  _entries = entries;
+  _capacity = (entries && capacity >= 2) ? capacity : 0;
+  _head = 0;
+  _tail = 0;
+  _queued = 0;
+  _overflows = 0;
+  _oversize = 0;
+  _drained = _batches = _merged = _failures = 0;
+}
+
+/*!
+ *  @brief  Ring index after index
+ *  @param  index
+ *          Current slot
+ *  @return Following slot
+ */
+uint8_t Adafruit_FRAM_SPI_Deferred::next(uint8_t index) const {
+  return (uint8_t)(index + 1) == _capacity ? 0 : (uint8_t)(index + 1);
+}
+
+/*!
+ *  @brief  Queues a write; ISR-safe, never blocks
+ *  @param  addr
+ *          FRAM address
+ *  @param  data
+ *          Bytes to write, copied before returning
+ *  @param  len
+ *          1 to FRAM_DEFERRED_PAYLOAD
+ *  @return false if the ring is full or len is out of range (both counted)
+ */
+bool Adafruit_FRAM_SPI_Deferred::push(uint32_t addr, const void *data,
+                                      uint8_t len) {
+  if (!_capacity) {
+    _overflows = _overflows + 1;
+    return false;
+  }
+  if (!len || len > FRAM_DEFERRED_PAYLOAD) {
+    _oversize = _oversize + 1;
+    return false;
+  }
+  uint8_t head = _head;
+  uint8_t n = next(head);
+  if (n == _tail) {
+    _overflows = _overflows + 1;
+    return false;
+  }
+
+  fram_deferred_entry_t &e = _entries[head];
+  e.addr = addr;
+  e.len = len;
+  memcpy(e.data, data, len);
+  FRAM_DEFERRED_BARRIER(); // Publish the entry before the index
+  _head = n;
+  _queued = _queued + 1;
+  return true;
+}
+
+/*!
+ *  @brief  Writes queued entries to FRAM, oldest first. Entries whose
+ *          address continues the previous one are merged into a single
+ *          transfer of up to FRAM_DEFERRED_BATCH bytes. A failed transfer
+ *          stops the drain and leaves its entries queued for the next call.
+ *  @param  max
+ *          Most entries to write, 0 for all that are queued
+ *  @return Number of entries written
+ */
+uint16_t Adafruit_FRAM_SPI_Deferred::drain(uint16_t max) {
+  uint8_t batch[FRAM_DEFERRED_BATCH];
+  uint16_t done = 0;
+
+  while (!max || done < max) {
+    uint8_t tail = _tail;
+    uint8_t head = _head;
+    if (tail == head) {
+      break;
+    }
+    FRAM_DEFERRED_BARRIER(); // Entries up to head are complete
+
+    uint32_t addr = _entries[tail].addr;
+    uint16_t len = 0;
+    uint16_t n = 0;
+    uint8_t i = tail;
+    while (i != head && (!max || done + n < max)) {
+      const fram_deferred_entry_t &e = _entries[i];
+      if (n && (e.addr != addr + len || len + e.len > sizeof(batch))) {
+        break;
+      }
+      memcpy(batch + len, e.data, e.len);
+      len += e.len;
+      n++;
+      i = next(i);
+    }
+
+    if (!_fram.writeEnable(true) || !_fram.write(addr, batch, len)) {
+      _failures++;
+      break;
+    }
+    FRAM_DEFERRED_BARRIER(); // Done with the slots before releasing them
+    _tail = i;
+    done += n;
+    _drained += n;
+    _batches++;
+    _merged += n - 1;
+  }
+  return done;
+}
+
+/*!
+ *  @brief  Entries waiting to be drained; callable from either side
+ *  @return Queued entry count
+ */
+uint8_t Adafruit_FRAM_SPI_Deferred::pending(void) const {
+  uint8_t head = _head;
+  uint8_t tail = _tail;
+  return head >= tail ? head - tail : _capacity - tail + head;
+}
+
+/*!
+ *  @brief  Copies the counters. Call from the consumer side.
+ *  @param  stats
+ *          Destination
+ */
+void Adafruit_FRAM_SPI_Deferred::stats(fram_deferred_stats_t *stats) const {
+  if (!stats) {
+    return;
+  }
+  stats->queued = stable(_queued);
+  stats->overflows = stable(_overflows);
+  stats->oversize = stable(_oversize);
+  stats->drained = _drained;
+  stats->batches = _batches;
+  stats->merged = _merged;
+  stats->failures = _failures;
+}
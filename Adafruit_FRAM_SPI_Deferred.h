@@ -0,0 +1,102 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Deferred.h
+ *
+ *  ISR-safe deferred write queue for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_DEFERRED_H_
+#define _ADAFRUIT_FRAM_SPI_DEFERRED_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+#ifndef FRAM_DEFERRED_PAYLOAD
+/// Largest payload one queued entry can carry
+#define FRAM_DEFERRED_PAYLOAD 8
+#endif
+
+#ifndef FRAM_DEFERRED_BATCH
+/// Largest merged write issued by drain(), in bytes (stack buffer)
+#define FRAM_DEFERRED_BATCH 64
+#endif
+
+// drain() copies a whole entry into the batch buffer before merging
+#if FRAM_DEFERRED_PAYLOAD > FRAM_DEFERRED_BATCH
+#error "FRAM_DEFERRED_PAYLOAD must not exceed FRAM_DEFERRED_BATCH"
+#endif
+
+/*!
+ *  @brief  One queued write
+ */
+typedef struct {
+  uint32_t addr;                       ///< FRAM address
+  uint8_t len;                         ///< Payload bytes used
+  uint8_t data[FRAM_DEFERRED_PAYLOAD]; ///< Payload
+} fram_deferred_entry_t;
+
+/*!
+ *  @brief  Queue counters. The first three belong to the producer, the
+ *          rest to the consumer; all wrap at 2^32.
+ */
+typedef struct {
+  uint32_t queued;    ///< Entries accepted by push()
+  uint32_t overflows; ///< Entries refused because the ring was full
+  uint32_t oversize;  ///< Entries refused for a bad length
+  uint32_t drained;   ///< Entries written to FRAM
+  uint32_t batches;   ///< Bus writes issued by drain()
+  uint32_t merged;    ///< Entries folded into a preceding entry's write
+  uint32_t failures;  ///< Bus writes that failed, left queued for retry
+} fram_deferred_stats_t;
+
+/*!
+ *  @brief  Lets an interrupt handler schedule small FRAM writes without
+ *          touching the bus. push() only copies into a caller-provided
+ *          single-producer, single-consumer ring and never blocks; drain(),
+ *          called from loop() or a task, writes the entries out in order,
+ *          merging runs of address-adjacent entries into one transfer.
+ *
+ *          One producer context (a single ISR, or ISRs that cannot preempt
+ *          each other) and one consumer context only. A ring of capacity N
+ *          holds N - 1 entries; N is at most 255. Queued data is not
+ *          visible to FRAM reads until drained.
+ */
+class Adafruit_FRAM_SPI_Deferred {
+public:
+  Adafruit_FRAM_SPI_Deferred(Adafruit_FRAM_SPI &fram,
+                             fram_deferred_entry_t *entries,
+                             uint8_t capacity);
+
+  bool push(uint32_t addr, const void *data, uint8_t len);
+
+  /*!
+   *  @brief  Queues the bytes of a value; ISR-safe
+   *  @param  addr
+   *          FRAM address
+   *  @param  value
+   *          Value to copy, at most FRAM_DEFERRED_PAYLOAD bytes
+   *  @return true if queued
+   */
+  template <typename T> bool put(uint32_t addr, const T &value) {
+    static_assert(sizeof(T) <= FRAM_DEFERRED_PAYLOAD,
+                  "value larger than FRAM_DEFERRED_PAYLOAD");
+    return push(addr, &value, sizeof(T));
+  }
+
+  uint16_t drain(uint16_t max = 0);
+  uint8_t pending(void) const;
+  void stats(fram_deferred_stats_t *stats) const;
+
+private:
+  uint8_t next(uint8_t index) const;
+
+  Adafruit_FRAM_SPI &_fram;
+  fram_deferred_entry_t *_entries;
+  uint8_t _capacity;
+  volatile uint8_t _head; // Written by the producer only
+  volatile uint8_t _tail; // Written by the consumer only
+  volatile uint32_t _queued, _overflows, _oversize;
+  uint32_t _drained, _batches, _merged, _failures;
+};
+
+#endif
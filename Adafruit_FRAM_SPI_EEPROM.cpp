@@ -0,0 +1,237 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_EEPROM.cpp
+ *
+ *  Arduino EEPROM compatible interface over a region of an
+ *  Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_EEPROM.h"
+
+/*!
+ *  @brief  Reads the referenced byte
+ *  @return Byte value
+ */
+Adafruit_FRAM_SPI_EERef::operator uint8_t() const {
+  return _eeprom.read(_idx);
+}
+
+/*!
+ *  @brief  Writes the referenced byte
+ *  @param  value
+ *          New value
+ *  @return This reference
+ */
+Adafruit_FRAM_SPI_EERef &Adafruit_FRAM_SPI_EERef::operator=(uint8_t value) {
+  _eeprom.write(_idx, value);
+  return *this;
+}
+
+/*!
+ *  @brief  Writes the referenced byte only if it differs
+ *  @param  value
+ *          New value
+ *  @return This reference
+ */
+Adafruit_FRAM_SPI_EERef &Adafruit_FRAM_SPI_EERef::update(uint8_t value) {
+  _eeprom.update(_idx, value);
+  return *this;
+}
+
+/*!
+ *  @brief  Creates an EEPROM façade over [base, base + size)
+ *  @param  fram
+ *          Device holding the region
+ *  @param  base
+ *          First byte of the region
+ *  @param  size
+ *          Region size in bytes, 0 to size it in begin()
+ *  @param  cache
+ *          Optional shadow of the region, size bytes, owned by the caller.
+ *          Needs a non-zero size, which bounds the region from then on.
+ */
+Adafruit_FRAM_SPI_EEPROM::Adafruit_FRAM_SPI_EEPROM(Adafruit_FRAM_SPI &fram,
+                                                   uint32_t base,
+                                                   uint32_t size,
+                                                   uint8_t *cache)
+    : _fram(fram), _base(base), _size(size), _cache(cache) {
+  _cacheSize = cache ? size : 0;
+  _cached = false;
+}
+
+/*!
+ *  @brief  Sizes the region and loads the cache. Call after the FRAM's
+ *          own begin().
+ *  @param  size
+ *          Region size as passed to EEPROM.begin() on ESP cores; 0 keeps
+ *          the constructor size, or the rest of the device if that was 0
+ *  @return true if the region fits the device and the cache loaded
+ */
+bool Adafruit_FRAM_SPI_EEPROM::begin(size_t size) {
+  uint32_t devSize = _fram.getSize();
+  _cached = false;
+  if (_cache && !_cacheSize) {
+    return false; // Cache length unknown
+  }
+  if (size) {
+    if (_cache && size > _cacheSize) {
+      return false; // Would overrun the cache
+    }
+    _size = size;
+  } else if (!_size && devSize > _base) {
+    _size = devSize - _base;
+  }
+  if (!_size || _base + _size > devSize || _base + _size < _base) {
+    return false;
+  }
+  if (_cache) {
+    if (_size > _cacheSize) {
+      return false;
+    }
+    _cached = _fram.read(_base, _cache, _size);
+    return _cached;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  ESP-style end(); drops the cache
+ */
+void Adafruit_FRAM_SPI_EEPROM::end(void) { _cached = false; }
+
+/*!
+ *  @brief  ESP-style commit(). Writes are never deferred, so there is
+ *          nothing to do.
+ *  @return true
+ */
+bool Adafruit_FRAM_SPI_EEPROM::commit(void) { return true; }
+
+/*!
+ *  @brief  Size of the region
+ *  @return Bytes addressable through this façade, saturated at 65535
+ */
+uint16_t Adafruit_FRAM_SPI_EEPROM::length(void) const {
+  return _size > 0xFFFF ? 0xFFFF : _size;
+}
+
+/*!
+ *  @brief  Checks that [idx, idx + len) lies inside the region
+ *  @param  idx
+ *          Byte index
+ *  @param  len
+ *          Number of bytes
+ *  @return true if in range
+ */
+bool Adafruit_FRAM_SPI_EEPROM::inRange(int idx, size_t len) const {
+  return idx >= 0 && (uint32_t)idx <= _size && len <= _size - (uint32_t)idx;
+}
+
+/*!
+ *  @brief  Reads one byte
+ *  @param  idx
+ *          Byte index
+ *  @return Byte value, 0xFF (erased EEPROM) if out of range or on error
+ */
+uint8_t Adafruit_FRAM_SPI_EEPROM::read(int idx) {
+  uint8_t value = 0xFF;
+  readBytes(idx, &value, 1);
+  return value;
+}
+
+/*!
+ *  @brief  Writes one byte
+ *  @param  idx
+ *          Byte index
+ *  @param  value
+ *          New value
+ */
+void Adafruit_FRAM_SPI_EEPROM::write(int idx, uint8_t value) {
+  if (!inRange(idx, 1) || !_fram.writeEnable(true) ||
+      !_fram.write8(_base + idx, value)) {
+    return;
+  }
+  if (_cached) {
+    _cache[idx] = value;
+  }
+}
+
+/*!
+ *  @brief  Writes one byte only if it differs from the stored value. Without
+ *          a cache this costs a read; since FRAM has no wear or erase stall,
+ *          skipping the write only saves bus time.
+ *  @param  idx
+ *          Byte index
+ *  @param  value
+ *          New value
+ */
+void Adafruit_FRAM_SPI_EEPROM::update(int idx, uint8_t value) {
+  if (_cached && inRange(idx, 1) && _cache[idx] == value) {
+    return;
+  }
+  if (!_cached && read(idx) == value) {
+    return;
+  }
+  write(idx, value);
+}
+
+/*!
+ *  @brief  Reads a block in one burst, or from the cache
+ *  @param  idx
+ *          Byte index of the first byte
+ *  @param  data
+ *          Destination
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_EEPROM::readBytes(int idx, void *data, size_t len) {
+  if (!inRange(idx, len)) {
+    return false;
+  }
+  if (_cached) {
+    memcpy(data, _cache + idx, len);
+    return true;
+  }
+  return _fram.read(_base + idx, (uint8_t *)data, len);
+}
+
+/*!
+ *  @brief  Writes a block in one burst. With a cache, unchanged leading and
+ *          trailing bytes are trimmed and nothing is sent if the block is
+ *          unchanged.
+ *  @param  idx
+ *          Byte index of the first byte
+ *  @param  data
+ *          Source
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_EEPROM::writeBytes(int idx, const void *data,
+                                          size_t len) {
+  if (!inRange(idx, len)) {
+    return false;
+  }
+  const uint8_t *src = (const uint8_t *)data;
+  size_t first = 0, last = len;
+  if (_cached) {
+    while (first < len && _cache[idx + first] == src[first]) {
+      first++;
+    }
+    while (last > first && _cache[idx + last - 1] == src[last - 1]) {
+      last--;
+    }
+    if (first == last) {
+      return true;
+    }
+  }
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + idx + first, src + first, last - first)) {
+    return false;
+  }
+  if (_cached) {
+    memcpy(_cache + idx + first, src + first, last - first);
+  }
+  return true;
+}
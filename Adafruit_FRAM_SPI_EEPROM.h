@@ -0,0 +1,123 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_EEPROM.h
+ *
+ *  Arduino EEPROM compatible interface over a region of an
+ *  Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_EEPROM_H_
+#define _ADAFRUIT_FRAM_SPI_EEPROM_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+class Adafruit_FRAM_SPI_EEPROM;
+
+/*!
+ *  @brief  Byte reference returned by Adafruit_FRAM_SPI_EEPROM::operator[],
+ *          like EERef in the AVR EEPROM library
+ */
+class Adafruit_FRAM_SPI_EERef {
+public:
+  /*!
+   *  @brief  Refers to one byte of an EEPROM façade
+   *  @param  eeprom
+   *          Owning façade
+   *  @param  idx
+   *          Byte index
+   */
+  Adafruit_FRAM_SPI_EERef(Adafruit_FRAM_SPI_EEPROM &eeprom, int idx)
+      : _eeprom(eeprom), _idx(idx) {}
+
+  operator uint8_t() const;
+  Adafruit_FRAM_SPI_EERef &operator=(uint8_t value);
+  /*!
+   *  @brief  Copies the value of another referenced byte
+   *  @param  ref
+   *          Byte to copy
+   *  @return This reference
+   */
+  Adafruit_FRAM_SPI_EERef &operator=(const Adafruit_FRAM_SPI_EERef &ref) {
+    return *this = (uint8_t)ref;
+  }
+  Adafruit_FRAM_SPI_EERef &update(uint8_t value);
+
+private:
+  Adafruit_FRAM_SPI_EEPROM &_eeprom;
+  int _idx;
+};
+
+/*!
+ *  @brief  Drop-in replacement for the Arduino EEPROM object (AVR and
+ *          ESP32/ESP8266 flavours) backed by FRAM. get() and put() move a
+ *          whole object in one burst and commit() has nothing to do, since
+ *          every write lands on the device immediately. With a shadow cache
+ *          of the region, read() and get() are served from RAM and update()
+ *          and put() skip bytes that did not change.
+ */
+class Adafruit_FRAM_SPI_EEPROM {
+public:
+  Adafruit_FRAM_SPI_EEPROM(Adafruit_FRAM_SPI &fram, uint32_t base = 0,
+                           uint32_t size = 0, uint8_t *cache = NULL);
+
+  bool begin(size_t size = 0);
+  void end(void);
+  bool commit(void);
+  uint16_t length(void) const;
+
+  uint8_t read(int idx);
+  void write(int idx, uint8_t value);
+  void update(int idx, uint8_t value);
+
+  bool readBytes(int idx, void *data, size_t len);
+  bool writeBytes(int idx, const void *data, size_t len);
+
+  /*!
+   *  @brief  Reads an object in one burst
+   *  @param  idx
+   *          Byte index of the object
+   *  @param  t
+   *          Object to fill
+   *  @return t
+   */
+  template <typename T> T &get(int idx, T &t) {
+    readBytes(idx, &t, sizeof(T));
+    return t;
+  }
+
+  /*!
+   *  @brief  Writes an object in one burst; with a cache only the span of
+   *          bytes that changed is sent
+   *  @param  idx
+   *          Byte index of the object
+   *  @param  t
+   *          Object to store
+   *  @return t
+   */
+  template <typename T> const T &put(int idx, const T &t) {
+    writeBytes(idx, &t, sizeof(T));
+    return t;
+  }
+
+  /*!
+   *  @brief  Accesses one byte, as in EEPROM[idx] = value
+   *  @param  idx
+   *          Byte index
+   *  @return Reference to the byte
+   */
+  Adafruit_FRAM_SPI_EERef operator[](int idx) {
+    return Adafruit_FRAM_SPI_EERef(*this, idx);
+  }
+
+private:
+  bool inRange(int idx, size_t len) const;
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size;
+  uint8_t *_cache;
+  uint32_t _cacheSize; // Length of _cache, fixed at construction
+  bool _cached;        // _cache mirrors the region
+};
+
+#endif
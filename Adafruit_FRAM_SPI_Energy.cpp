@@ -0,0 +1,174 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Energy.cpp
+ *
+ *  Energy estimates for Adafruit_FRAM_SPI activity.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Energy.h"
+
+/*!
+ *  @brief  Creates an estimator for one FRAM instance
+ *  @param  fram
+ *          Instance to account for, with a statistics block attached
+ *  @param  millivolts
+ *          Supply voltage of the FRAM
+ */
+Adafruit_FRAM_SPI_Energy::Adafruit_FRAM_SPI_Energy(Adafruit_FRAM_SPI &fram,
+                                                   uint16_t millivolts)
+    : _fram(fram), _millivolts(millivolts) {
+  _beginMillis = _lastMillis = 0;
+  memset(&_beginStats, 0, sizeof(_beginStats));
+  memset(&_lastStats, 0, sizeof(_lastStats));
+  memset(&_beginPower, 0, sizeof(_beginPower));
+  memset(&_lastPower, 0, sizeof(_lastPower));
+}
+
+/*!
+ *  @brief  Starts accounting from now. Call after the FRAM's begin().
+ *  @return false if the instance has no statistics block attached
+ */
+bool Adafruit_FRAM_SPI_Energy::begin(void) {
+  if (!snapshot(&_beginStats, &_beginPower, &_beginMillis)) {
+    return false;
+  }
+  _lastStats = _beginStats;
+  _lastPower = _beginPower;
+  _lastMillis = _beginMillis;
+  return true;
+}
+
+/*!
+ *  @brief  Estimates the energy used since the previous sample() (or
+ *          begin()) and starts a new window
+ *  @param  window
+ *          Receives the estimate
+ *  @return false if the instance has no statistics block attached
+ */
+bool Adafruit_FRAM_SPI_Energy::sample(fram_spi_energy_t *window) {
+  fram_spi_stats_t stats;
+  fram_spi_power_stats_t power;
+  uint32_t now;
+
+  if (!window || !snapshot(&stats, &power, &now)) {
+    return false;
+  }
+  estimate(_lastStats, stats, _lastPower, power, now - _lastMillis, window);
+  _lastStats = stats;
+  _lastPower = power;
+  _lastMillis = now;
+  return true;
+}
+
+/*!
+ *  @brief  Estimates the energy used since begin()
+ *  @param  energy
+ *          Receives the estimate
+ *  @return false if the instance has no statistics block attached
+ */
+bool Adafruit_FRAM_SPI_Energy::total(fram_spi_energy_t *energy) {
+  fram_spi_stats_t stats;
+  fram_spi_power_stats_t power;
+  uint32_t now;
+
+  if (!energy || !snapshot(&stats, &power, &now)) {
+    return false;
+  }
+  estimate(_beginStats, stats, _beginPower, power, now - _beginMillis,
+           energy);
+  return true;
+}
+
+/*!
+ *  @brief  Reads the instance's counters
+ *  @param  stats
+ *          Receives the I/O statistics
+ *  @param  power
+ *          Receives the sleep bookkeeping
+ *  @param  now
+ *          Receives millis() at the time of the snapshot
+ *  @return false if the instance has no statistics block attached
+ */
+bool Adafruit_FRAM_SPI_Energy::snapshot(fram_spi_stats_t *stats,
+                                        fram_spi_power_stats_t *power,
+                                        uint32_t *now) {
+  if (!_fram.getStats(stats)) {
+    return false;
+  }
+  _fram.getPowerStats(power);
+  *now = millis();
+  return true;
+}
+
+/*!
+ *  @brief  Converts counter deltas into energy. Bus time is charged at the
+ *          read or write operating current, wake recovery and the remaining
+ *          awake time at the standby current, and sleep time at the current
+ *          of the mode that was entered.
+ *  @param  s0
+ *          I/O statistics at the start of the window
+ *  @param  s1
+ *          I/O statistics at the end of the window
+ *  @param  p0
+ *          Sleep bookkeeping at the start of the window
+ *  @param  p1
+ *          Sleep bookkeeping at the end of the window
+ *  @param  windowMillis
+ *          Window length
+ *  @param  out
+ *          Receives the estimate
+ */
+void Adafruit_FRAM_SPI_Energy::estimate(const fram_spi_stats_t &s0,
+                                        const fram_spi_stats_t &s1,
+                                        const fram_spi_power_stats_t &p0,
+                                        const fram_spi_power_stats_t &p1,
+                                        uint32_t windowMillis,
+                                        fram_spi_energy_t *out) {
+  // uA * us * V = pJ, so scale by 1e-6 for uJ
+  float volts = _millivolts / 1000.0f;
+  float read_uA = _fram.getActiveMicroamps(false);
+  float write_uA = _fram.getActiveMicroamps(true);
+  float standby_uA = _fram.getStandbyMicroamps();
+  float busMicros = 0;
+
+  out->windowMillis = windowMillis;
+  out->totalMicrojoules = 0;
+  for (uint8_t op = 0; op < FRAM_OP_CLASSES; op++) {
+    float us = (float)(s1.opMicros[op] - s0.opMicros[op]);
+    float uA;
+    switch (op) {
+    case FRAM_OP_WRITE:
+    case FRAM_OP_WRITE8:
+      uA = write_uA;
+      break;
+    case FRAM_OP_WAKE:
+      uA = standby_uA;
+      break;
+    default:
+      uA = read_uA;
+      break;
+    }
+    busMicros += us;
+    out->opCounts[op] = s1.opCounts[op] - s0.opCounts[op];
+    out->opMicrojoules[op] = uA * us * volts * 1e-6f;
+    out->totalMicrojoules += out->opMicrojoules[op];
+  }
+
+  // nA * ms * V = pJ as well
+  float sleepMillis = 0;
+  out->sleepMicrojoules = 0;
+  for (uint8_t m = 0; m < FRAM_LP_MODES; m++) {
+    float ms = (float)(p1.modeMillis[m] - p0.modeMillis[m]);
+    sleepMillis += ms;
+    out->sleepMicrojoules +=
+        _fram.getLowPowerNanoamps((fram_lowpower_t)m) * ms * volts * 1e-6f;
+  }
+
+  float idleMicros = windowMillis * 1000.0f - busMicros - sleepMillis * 1000.0f;
+  if (idleMicros < 0) {
+    idleMicros = 0;
+  }
+  out->standbyMicrojoules = standby_uA * idleMicros * volts * 1e-6f;
+  out->totalMicrojoules += out->sleepMicrojoules + out->standbyMicrojoules;
+}
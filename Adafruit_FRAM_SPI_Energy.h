@@ -0,0 +1,55 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Energy.h
+ *
+ *  Energy estimates for Adafruit_FRAM_SPI activity.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_ENERGY_H_
+#define _ADAFRUIT_FRAM_SPI_ENERGY_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/*!
+ *  @brief  Estimated FRAM energy over a time window
+ */
+typedef struct {
+  uint32_t windowMillis;                ///< Length of the window
+  float opMicrojoules[FRAM_OP_CLASSES]; ///< Energy per fram_op_t
+  uint32_t opCounts[FRAM_OP_CLASSES];   ///< Transfers per fram_op_t
+  float standbyMicrojoules;             ///< Idle time with CS high
+  float sleepMicrojoules;               ///< Time in low-power modes
+  float totalMicrojoules;               ///< Sum of all the above
+} fram_spi_energy_t;
+
+/*!
+ *  @brief  Turns the bus time and sleep time recorded by an Adafruit_FRAM_SPI
+ *          into energy, using the part's typical currents from the device
+ *          table. The instance must have a statistics block attached with
+ *          setStats().
+ */
+class Adafruit_FRAM_SPI_Energy {
+public:
+  Adafruit_FRAM_SPI_Energy(Adafruit_FRAM_SPI &fram, uint16_t millivolts = 3300);
+
+  bool begin(void);
+  bool sample(fram_spi_energy_t *window);
+  bool total(fram_spi_energy_t *energy);
+
+private:
+  bool snapshot(fram_spi_stats_t *stats, fram_spi_power_stats_t *power,
+                uint32_t *now);
+  void estimate(const fram_spi_stats_t &s0, const fram_spi_stats_t &s1,
+                const fram_spi_power_stats_t &p0,
+                const fram_spi_power_stats_t &p1, uint32_t windowMillis,
+                fram_spi_energy_t *out);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint16_t _millivolts;
+  uint32_t _beginMillis, _lastMillis;
+  fram_spi_stats_t _beginStats, _lastStats;
+  fram_spi_power_stats_t _beginPower, _lastPower;
+};
+
+#endif
@@ -0,0 +1,332 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_FatFs.cpp
+ *
+ *  FatFs disk I/O layer for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_FatFs.h"
+
+#ifdef FRAM_SPI_HAS_FATFS
+
+/*!
+ *  @brief  Creates a disk over an FRAM region
+ *  @param  fram
+ *          Device holding the volume
+ *  @param  base
+ *          First byte of the region
+ *  @param  size
+ *          Region size in bytes, 0 for the rest of the device
+ *  @param  cache
+ *          FAT cache storage, cacheSectors * 512 bytes, or NULL
+ *  @param  cacheSectors
+ *          Sectors in the FAT cache, at most FRAM_FATFS_CACHE_MAX
+ */
+Adafruit_FRAM_SPI_FatFs::Adafruit_FRAM_SPI_FatFs(Adafruit_FRAM_SPI &fram,
+                                                 uint32_t base, uint32_t size,
+                                                 uint8_t *cache,
+                                                 uint8_t cacheSectors)
+    : _fram(fram), _base(base), _size(size), _cache(cache) {
+  _cacheSectors = cache ? cacheSectors : 0;
+  if (_cacheSectors > FRAM_FATFS_CACHE_MAX) {
+    _cacheSectors = FRAM_FATFS_CACHE_MAX;
+  }
+  _sectors = 0;
+  _cacheDirty = 0;
+  _cacheValid = 0;
+  _clock = 0;
+  _fatStart = _fatEnd = 0;
+  _ready = false;
+}
+
+/*!
+ *  @brief  disk_initialize(): sizes the volume from the detected part and
+ *          locates the FAT from the boot sector, if one is present
+ *  @return 0, or STA_NOINIT if the FRAM has not been begun
+ */
+DSTATUS Adafruit_FRAM_SPI_FatFs::initialize(void) {
+  uint32_t size = _size;
+  uint32_t devSize = _fram.getSize();
+  if (!size && devSize > _base) {
+    size = devSize - _base;
+  }
+  _sectors = size / FRAM_FATFS_SECTOR_SIZE;
+  _cacheDirty = 0;
+  _cacheValid = 0;
+  _fatStart = _fatEnd = 0;
+  _ready = _sectors != 0;
+  if (!_ready) {
+    return STA_NOINIT;
+  }
+
+  BYTE boot[FRAM_FATFS_SECTOR_SIZE];
+  if (_fram.read(_base, boot, sizeof(boot))) {
+    parseBootSector(boot);
+  }
+  return 0;
+}
+
+/*!
+ *  @brief  disk_status()
+ *  @return 0 once initialized, STA_NOINIT before
+ */
+DSTATUS Adafruit_FRAM_SPI_FatFs::status(void) {
+  return _ready ? 0 : STA_NOINIT;
+}
+
+/*!
+ *  @brief  disk_read(): one burst for the whole request, patched with any
+ *          newer sectors held in the FAT cache
+ *  @param  buff
+ *          Destination
+ *  @param  sector
+ *          First sector
+ *  @param  count
+ *          Number of sectors
+ *  @return RES_OK, RES_PARERR if out of range, RES_ERROR on a bus error
+ */
+DRESULT Adafruit_FRAM_SPI_FatFs::read(BYTE *buff, fram_fatfs_lba_t sector,
+                                      UINT count) {
+  if (!_ready) {
+    return RES_NOTRDY;
+  }
+  if (!count || sector >= _sectors || count > _sectors - sector) {
+    return RES_PARERR;
+  }
+
+  if (count == 1 && isFat(sector)) {
+    int8_t i = lookup(sector);
+    if (i < 0) {
+      i = allocate(sector);
+      if (i >= 0 &&
+          !_fram.read(_base + sector * FRAM_FATFS_SECTOR_SIZE,
+                      _cache + i * FRAM_FATFS_SECTOR_SIZE,
+                      FRAM_FATFS_SECTOR_SIZE)) {
+        _cacheValid &= ~(1 << i);
+        return RES_ERROR;
+      }
+    }
+    if (i >= 0) {
+      memcpy(buff, _cache + i * FRAM_FATFS_SECTOR_SIZE,
+             FRAM_FATFS_SECTOR_SIZE);
+      return RES_OK;
+    }
+  }
+
+  if (!_fram.read(_base + sector * FRAM_FATFS_SECTOR_SIZE, buff,
+                  count * FRAM_FATFS_SECTOR_SIZE)) {
+    return RES_ERROR;
+  }
+  for (uint8_t i = 0; i < _cacheSectors; i++) {
+    if ((_cacheDirty & (1 << i)) && _cacheSector[i] >= sector &&
+        _cacheSector[i] < sector + count) {
+      memcpy(buff + (_cacheSector[i] - sector) * FRAM_FATFS_SECTOR_SIZE,
+             _cache + i * FRAM_FATFS_SECTOR_SIZE, FRAM_FATFS_SECTOR_SIZE);
+    }
+  }
+  return RES_OK;
+}
+
+/*!
+ *  @brief  disk_write(): single FAT sectors are absorbed by the cache,
+ *          everything else is one WREN+WRITE burst
+ *  @param  buff
+ *          Data to write
+ *  @param  sector
+ *          First sector
+ *  @param  count
+ *          Number of sectors
+ *  @return RES_OK, RES_PARERR if out of range, RES_ERROR on a bus error
+ */
+DRESULT Adafruit_FRAM_SPI_FatFs::write(const BYTE *buff,
+                                       fram_fatfs_lba_t sector, UINT count) {
+  if (!_ready) {
+    return RES_NOTRDY;
+  }
+  if (!count || sector >= _sectors || count > _sectors - sector) {
+    return RES_PARERR;
+  }
+
+  if (count == 1 && isFat(sector)) {
+    int8_t i = lookup(sector);
+    if (i < 0) {
+      i = allocate(sector);
+    }
+    if (i >= 0) {
+      memcpy(_cache + i * FRAM_FATFS_SECTOR_SIZE, buff,
+             FRAM_FATFS_SECTOR_SIZE);
+      _cacheDirty |= 1 << i;
+      return RES_OK;
+    }
+  }
+
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + sector * FRAM_FATFS_SECTOR_SIZE, buff,
+                   count * FRAM_FATFS_SECTOR_SIZE)) {
+    return RES_ERROR;
+  }
+
+  // The burst supersedes any cached copy in its range. Updated only once
+  // the data is in FRAM, so a failed burst leaves the cache as it was.
+  for (uint8_t i = 0; i < _cacheSectors; i++) {
+    if ((_cacheValid & (1 << i)) && _cacheSector[i] >= sector &&
+        _cacheSector[i] < sector + count) {
+      memcpy(_cache + i * FRAM_FATFS_SECTOR_SIZE,
+             buff + (_cacheSector[i] - sector) * FRAM_FATFS_SECTOR_SIZE,
+             FRAM_FATFS_SECTOR_SIZE);
+      _cacheDirty &= ~(1 << i);
+    }
+  }
+  if (sector == 0) {
+    parseBootSector(buff);
+  }
+  return RES_OK;
+}
+
+/*!
+ *  @brief  disk_ioctl()
+ *  @param  cmd
+ *          CTRL_SYNC flushes the FAT cache; GET_SECTOR_COUNT,
+ *          GET_SECTOR_SIZE and GET_BLOCK_SIZE describe the region;
+ *          CTRL_TRIM is accepted and ignored since FRAM needs no erase
+ *  @param  buff
+ *          Command argument or result
+ *  @return RES_OK, RES_PARERR for unknown commands, RES_ERROR on a bus
+ *          error while syncing
+ */
+DRESULT Adafruit_FRAM_SPI_FatFs::ioctl(BYTE cmd, void *buff) {
+  if (!_ready) {
+    return RES_NOTRDY;
+  }
+  switch (cmd) {
+  case CTRL_SYNC:
+    return flush() ? RES_OK : RES_ERROR;
+  case GET_SECTOR_COUNT:
+    *(fram_fatfs_lba_t *)buff = _sectors;
+    return RES_OK;
+  case GET_SECTOR_SIZE:
+    *(WORD *)buff = FRAM_FATFS_SECTOR_SIZE;
+    return RES_OK;
+  case GET_BLOCK_SIZE:
+    *(DWORD *)buff = 1;
+    return RES_OK;
+#ifdef CTRL_TRIM
+  case CTRL_TRIM:
+    return RES_OK;
+#endif
+  default:
+    return RES_PARERR;
+  }
+}
+
+/*!
+ *  @brief  Writes every dirty cached sector back
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_FatFs::flush(void) {
+  bool ok = true;
+  for (uint8_t i = 0; i < _cacheSectors; i++) {
+    ok = flushEntry(i) && ok;
+  }
+  return ok;
+}
+
+/*!
+ *  @brief  Writes one cached sector back if it is dirty
+ *  @param  i
+ *          Cache slot
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_FatFs::flushEntry(uint8_t i) {
+  if (!(_cacheDirty & (1 << i))) {
+    return true;
+  }
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + _cacheSector[i] * FRAM_FATFS_SECTOR_SIZE,
+                   _cache + i * FRAM_FATFS_SECTOR_SIZE,
+                   FRAM_FATFS_SECTOR_SIZE)) {
+    return false;
+  }
+  _cacheDirty &= ~(1 << i);
+  return true;
+}
+
+/*!
+ *  @brief  Finds a sector in the cache and marks it recently used
+ *  @param  sector
+ *          Sector number
+ *  @return Cache slot, -1 if not cached
+ */
+int8_t Adafruit_FRAM_SPI_FatFs::lookup(uint32_t sector) {
+  for (uint8_t i = 0; i < _cacheSectors; i++) {
+    if ((_cacheValid & (1 << i)) && _cacheSector[i] == sector) {
+      _cacheStamp[i] = ++_clock;
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*!
+ *  @brief  Claims a cache slot for a sector, writing back the least
+ *          recently used one if needed. The slot's data is not loaded.
+ *  @param  sector
+ *          Sector number
+ *  @return Cache slot, -1 if there is no cache or the eviction failed
+ */
+int8_t Adafruit_FRAM_SPI_FatFs::allocate(uint32_t sector) {
+  int8_t victim = -1;
+  for (uint8_t i = 0; i < _cacheSectors; i++) {
+    if (!(_cacheValid & (1 << i))) {
+      victim = i;
+      break;
+    }
+    if (victim < 0 ||
+        (uint16_t)(_clock - _cacheStamp[i]) >
+            (uint16_t)(_clock - _cacheStamp[victim])) {
+      victim = i;
+    }
+  }
+  if (victim < 0 || !flushEntry(victim)) {
+    return -1;
+  }
+  _cacheSector[victim] = sector;
+  _cacheStamp[victim] = ++_clock;
+  _cacheValid |= 1 << victim;
+  return victim;
+}
+
+/*!
+ *  @brief  Checks whether a sector belongs to the FAT(s)
+ *  @param  sector
+ *          Sector number
+ *  @return true if the sector should go through the cache
+ */
+bool Adafruit_FRAM_SPI_FatFs::isFat(uint32_t sector) {
+  return _cacheSectors && sector >= _fatStart && sector < _fatEnd;
+}
+
+/*!
+ *  @brief  Locates the FAT(s) from a FAT12/16/32 boot sector (no partition
+ *          table, as made by f_mkfs with FM_SFD)
+ *  @param  buff
+ *          Sector 0 contents
+ */
+void Adafruit_FRAM_SPI_FatFs::parseBootSector(const BYTE *buff) {
+  _fatStart = _fatEnd = 0;
+  if (buff[510] != 0x55 || buff[511] != 0xAA ||
+      (buff[11] | (buff[12] << 8)) != FRAM_FATFS_SECTOR_SIZE) {
+    return;
+  }
+  uint32_t reserved = buff[14] | (buff[15] << 8);
+  uint32_t fatSize = buff[22] | (buff[23] << 8);
+  if (!fatSize) {
+    fatSize = buff[36] | (buff[37] << 8) | ((uint32_t)buff[38] << 16) |
+              ((uint32_t)buff[39] << 24);
+  }
+  _fatStart = reserved;
+  _fatEnd = reserved + buff[16] * fatSize;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_FatFs.h
+ *
+ *  FatFs disk I/O layer for Adafruit_FRAM_SPI. Only built when the FatFs
+ *  headers (ff.h, diskio.h) are available.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_FATFS_H_
+#define _ADAFRUIT_FRAM_SPI_FATFS_H_
+
+#if defined(__has_include)
+#if __has_include(<ff.h>) && __has_include(<diskio.h>)
+#define FRAM_SPI_HAS_FATFS 1
+#endif
+#endif
+
+#ifdef FRAM_SPI_HAS_FATFS
+
+#include "Adafruit_FRAM_SPI.h"
+extern "C" {
+#include <diskio.h>
+#include <ff.h>
+}
+
+/// Sector size presented to FatFs
+#define FRAM_FATFS_SECTOR_SIZE 512
+/// Most sectors the FAT cache can hold
+#define FRAM_FATFS_CACHE_MAX 4
+
+#if defined(FF_LBA64)
+typedef LBA_t fram_fatfs_lba_t; ///< Sector number type of this FatFs
+#else
+typedef DWORD fram_fatfs_lba_t; ///< Sector number type of this FatFs
+#endif
+
+/*!
+ *  @brief  Serves a FAT volume from an FRAM region. Multi-sector requests
+ *          map to a single burst, TRIM is a no-op, and single-sector
+ *          accesses to the FAT itself go through a small write-back cache
+ *          that absorbs the repeated FAT updates of small-file writes.
+ *          The cache is flushed on CTRL_SYNC (f_sync/f_close/f_unmount).
+ *
+ *          Use FRAM_SPI_FATFS_DISKIO() once in the sketch to route the
+ *          FatFs disk_*() calls to an instance.
+ */
+class Adafruit_FRAM_SPI_FatFs {
+public:
+  Adafruit_FRAM_SPI_FatFs(Adafruit_FRAM_SPI &fram, uint32_t base = 0,
+                          uint32_t size = 0, uint8_t *cache = NULL,
+                          uint8_t cacheSectors = 0);
+
+  DSTATUS initialize(void);
+  DSTATUS status(void);
+  DRESULT read(BYTE *buff, fram_fatfs_lba_t sector, UINT count);
+  DRESULT write(const BYTE *buff, fram_fatfs_lba_t sector, UINT count);
+  DRESULT ioctl(BYTE cmd, void *buff);
+
+private:
+  bool flush(void);
+  bool flushEntry(uint8_t i);
+  int8_t lookup(uint32_t sector);
+  int8_t allocate(uint32_t sector);
+  bool isFat(uint32_t sector);
+  void parseBootSector(const BYTE *buff);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size, _sectors;
+  uint8_t *_cache;
+  uint8_t _cacheSectors;
+  uint32_t _cacheSector[FRAM_FATFS_CACHE_MAX];
+  uint16_t _cacheStamp[FRAM_FATFS_CACHE_MAX];
+  uint8_t _cacheDirty;
+  uint8_t _cacheValid;
+  uint16_t _clock;
+  uint32_t _fatStart, _fatEnd;
+  bool _ready;
+};
+
+/// Defines the FatFs disk_*() functions for physical drive 0 on top of an
+/// Adafruit_FRAM_SPI_FatFs instance
+#define FRAM_SPI_FATFS_DISKIO(disk)                                            \
+  extern "C" DSTATUS disk_initialize(BYTE pdrv) {                              \
+    return pdrv ? STA_NOINIT : (disk).initialize();                            \
+  }                                                                            \
+  extern "C" DSTATUS disk_status(BYTE pdrv) {                                  \
+    return pdrv ? STA_NOINIT : (disk).status();                                \
+  }                                                                            \
+  extern "C" DRESULT disk_read(BYTE pdrv, BYTE *buff,                          \
+                               fram_fatfs_lba_t sector, UINT count) {          \
+    return pdrv ? RES_PARERR : (disk).read(buff, sector, count);               \
+  }                                                                            \
+  extern "C" DRESULT disk_write(BYTE pdrv, const BYTE *buff,                   \
+                                fram_fatfs_lba_t sector, UINT count) {         \
+    return pdrv ? RES_PARERR : (disk).write(buff, sector, count);              \
+  }                                                                            \
+  extern "C" DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {             \
+    return pdrv ? RES_PARERR : (disk).ioctl(cmd, buff);                        \
+  }
+
+#endif
+
+#endif
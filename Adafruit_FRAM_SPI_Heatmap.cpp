@@ -0,0 +1,157 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Heatmap.cpp
+ *
+ *  Per-region read/write access counters for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Heatmap.h"
+#include "Adafruit_FRAM_SPI_Atomic.h"
+
+/*!
+ *  @brief  Creates a heatmap over caller-owned counters
+ *  @param  counters
+ *          Counter storage, see FRAM_HEATMAP_COUNTERS()
+ *  @param  length
+ *          Number of uint16_t in counters
+ */
+Adafruit_FRAM_SPI_Heatmap::Adafruit_FRAM_SPI_Heatmap(uint16_t *counters,
+                                                     uint32_t length) {
+  _counters = counters;
+  _length = counters ? length : 0;
+  _buckets = 0;
+  _shift = 0;
+}
+
+/*!
+ *  @brief  Sizes the map for a device and clears it
+ *  @param  capacity
+ *          Device size in bytes, e.g. Adafruit_FRAM_SPI::getSize()
+ *  @param  bucketShift
+ *          log2 of the bucket size, 8 gives 256 byte buckets
+ *  @return true if the counter storage is large enough
+ */
+bool Adafruit_FRAM_SPI_Heatmap::begin(uint32_t capacity, uint8_t bucketShift) {
+  if (!capacity || bucketShift > 31 ||
+      FRAM_HEATMAP_COUNTERS(capacity, bucketShift) > _length) {
+    _buckets = 0;
+    return false;
+  }
+  _shift = bucketShift;
+  _buckets = FRAM_HEATMAP_COUNTERS(capacity, bucketShift) / 2;
+  reset();
+  return true;
+}
+
+/*!
+ *  @brief  Counts one access against every bucket it touches
+ *  @param  write
+ *          true for a write, false for a read
+ *  @param  addr
+ *          First byte accessed
+ *  @param  length
+ *          Bytes accessed
+ */
+void Adafruit_FRAM_SPI_Heatmap::record(bool write, uint32_t addr,
+                                       uint32_t length) {
+  if (!_buckets || !length) {
+    return;
+  }
+
+  uint32_t first = addr >> _shift;
+  uint32_t last = (addr + length - 1) >> _shift;
+  volatile uint16_t *row = _counters + (write ? _buckets : 0);
+  for (uint32_t b = first; b <= last && b < _buckets; b++) {
+    fram_spi_inc16_sat(&row[b]);
+  }
+}
+
+/*!
+ *  @brief  Zeroes every counter
+ */
+void Adafruit_FRAM_SPI_Heatmap::reset(void) {
+  for (uint32_t i = 0; i < 2 * _buckets; i++) {
+    _counters[i] = 0;
+  }
+}
+
+/*!
+ *  @brief  Number of buckets covering the device
+ *  @return Bucket count, 0 before a successful begin()
+ */
+uint32_t Adafruit_FRAM_SPI_Heatmap::buckets(void) const { return _buckets; }
+
+/*!
+ *  @brief  Bytes covered by one bucket
+ *  @return Bucket size in bytes
+ */
+uint32_t Adafruit_FRAM_SPI_Heatmap::bucketSize(void) const {
+  return 1UL << _shift;
+}
+
+/*!
+ *  @brief  Read counter of a bucket
+ *  @param  bucket
+ *          Bucket index, i.e. address >> bucketShift
+ *  @return Reads touching the bucket
+ */
+uint16_t Adafruit_FRAM_SPI_Heatmap::reads(uint32_t bucket) const {
+  return bucket < _buckets ? _counters[bucket] : 0;
+}
+
+/*!
+ *  @brief  Write counter of a bucket
+ *  @param  bucket
+ *          Bucket index, i.e. address >> bucketShift
+ *  @return Writes touching the bucket
+ */
+uint16_t Adafruit_FRAM_SPI_Heatmap::writes(uint32_t bucket) const {
+  return bucket < _buckets ? _counters[_buckets + bucket] : 0;
+}
+
+/*!
+ *  @brief  Streams a binary dump: 'F', 'M', bucket shift, 0, uint32 bucket
+ *          count, then every read counter and every write counter as
+ *          little-endian uint16
+ *  @param  out
+ *          Destination
+ *  @return Bytes written
+ */
+size_t Adafruit_FRAM_SPI_Heatmap::writeTo(Print &out) const {
+  uint8_t hdr[8] = {'F',
+                    'M',
+                    _shift,
+                    0,
+                    (uint8_t)(_buckets & 0xFF),
+                    (uint8_t)(_buckets >> 8),
+                    (uint8_t)(_buckets >> 16),
+                    (uint8_t)(_buckets >> 24)};
+  size_t n = out.write(hdr, sizeof(hdr));
+  for (uint32_t i = 0; i < 2 * _buckets; i++) {
+    uint8_t c[2] = {(uint8_t)(_counters[i] & 0xFF),
+                    (uint8_t)(_counters[i] >> 8)};
+    n += out.write(c, 2);
+  }
+  return n;
+}
+
+/*!
+ *  @brief  Prints the touched buckets as CSV: start address,reads,writes
+ *  @param  out
+ *          Destination
+ */
+void Adafruit_FRAM_SPI_Heatmap::printTo(Print &out) const {
+  for (uint32_t b = 0; b < _buckets; b++) {
+    uint16_t r = reads(b), w = writes(b);
+    if (!r && !w) {
+      continue;
+    }
+    out.print(F("0x"));
+    out.print(b << _shift, HEX);
+    out.print(',');
+    out.print(r);
+    out.print(',');
+    out.println(w);
+  }
+}
@@ -0,0 +1,47 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Heatmap.h
+ *
+ *  Per-region read/write access counters for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_HEATMAP_H_
+#define _ADAFRUIT_FRAM_SPI_HEATMAP_H_
+
+#include <Arduino.h>
+
+/// Counter array length needed for a device of size bytes cut into
+/// 2^shift byte buckets (one read and one write counter per bucket)
+#define FRAM_HEATMAP_COUNTERS(size, shift)                                     \
+  (2 * (((uint32_t)(size) + (1UL << (shift)) - 1) >> (shift)))
+
+/*!
+ *  @brief  Counts reads and writes per fixed-size address bucket. A
+ *          transfer spanning several buckets counts once in each. Counters
+ *          are caller-owned uint16_t that saturate at 65535.
+ */
+class Adafruit_FRAM_SPI_Heatmap {
+public:
+  Adafruit_FRAM_SPI_Heatmap(uint16_t *counters, uint32_t length);
+
+  bool begin(uint32_t capacity, uint8_t bucketShift = 8);
+  void record(bool write, uint32_t addr, uint32_t length);
+  void reset(void);
+
+  uint32_t buckets(void) const;
+  uint32_t bucketSize(void) const;
+  uint16_t reads(uint32_t bucket) const;
+  uint16_t writes(uint32_t bucket) const;
+
+  size_t writeTo(Print &out) const;
+  void printTo(Print &out) const;
+
+private:
+  volatile uint16_t *_counters;
+  uint32_t _length;
+  uint32_t _buckets;
+  uint8_t _shift;
+};
+
+#endif
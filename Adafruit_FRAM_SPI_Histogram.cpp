@@ -0,0 +1,133 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Histogram.cpp
+ *
+ *  Fixed-bucket latency histograms for Adafruit_FRAM_SPI operations.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Histogram.h"
+#include "Adafruit_FRAM_SPI_Atomic.h"
+
+/// Row labels used by printTo(), in fram_op_t order
+static const char *const _op_names[FRAM_OP_CONTROL] = {
+    "read", "write", "read8", "write8", "status", "wake"};
+
+/*!
+ *  @brief  Creates an empty histogram set
+ */
+Adafruit_FRAM_SPI_Histogram::Adafruit_FRAM_SPI_Histogram(void) { reset(); }
+
+/*!
+ *  @brief  Maps a latency onto its log2 bucket
+ *  @param  micros
+ *          Latency in microseconds
+ *  @return 0 for 0 us, n for [2^(n-1), 2^n) us, clamped to the last bucket
+ */
+uint8_t Adafruit_FRAM_SPI_Histogram::bucketFor(uint32_t micros) {
+  uint8_t bucket = 0;
+  while (micros && bucket < FRAM_HIST_BUCKETS - 1) {
+    micros >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+/*!
+ *  @brief  Adds one sample; safe to call from an ISR
+ *  @param  op
+ *          Operation class, FRAM_OP_CONTROL samples are ignored
+ *  @param  micros
+ *          Measured latency in microseconds
+ */
+void Adafruit_FRAM_SPI_Histogram::record(fram_op_t op, uint32_t micros) {
+  if (op >= FRAM_OP_CONTROL) {
+    return;
+  }
+  fram_spi_inc16_sat(&_counts[op][bucketFor(micros)]);
+}
+
+/*!
+ *  @brief  Clears every bucket
+ */
+void Adafruit_FRAM_SPI_Histogram::reset(void) {
+  for (uint8_t op = 0; op < FRAM_OP_CONTROL; op++) {
+    for (uint8_t b = 0; b < FRAM_HIST_BUCKETS; b++) {
+      _counts[op][b] = 0;
+    }
+  }
+}
+
+/*!
+ *  @brief  Reads one bucket
+ *  @param  op
+ *          Operation class
+ *  @param  bucket
+ *          Bucket index, see bucketFor()
+ *  @return Sample count, 0 for out of range arguments
+ */
+uint16_t Adafruit_FRAM_SPI_Histogram::count(fram_op_t op,
+                                            uint8_t bucket) const {
+  if (op >= FRAM_OP_CONTROL || bucket >= FRAM_HIST_BUCKETS) {
+    return 0;
+  }
+  return _counts[op][bucket];
+}
+
+/*!
+ *  @brief  Writes a compact binary dump: 'F', 'H', op count, bucket count,
+ *          then every counter as little-endian uint16 in row-major order
+ *  @param  buffer
+ *          Destination
+ *  @param  size
+ *          Size of buffer, at least FRAM_HIST_SERIALIZED_SIZE
+ *  @return Bytes written, 0 if the buffer is too small
+ */
+size_t Adafruit_FRAM_SPI_Histogram::serialize(uint8_t *buffer,
+                                              size_t size) const {
+  if (!buffer || size < FRAM_HIST_SERIALIZED_SIZE) {
+    return 0;
+  }
+
+  size_t i = 0;
+  buffer[i++] = 'F';
+  buffer[i++] = 'H';
+  buffer[i++] = FRAM_OP_CONTROL;
+  buffer[i++] = FRAM_HIST_BUCKETS;
+  for (uint8_t op = 0; op < FRAM_OP_CONTROL; op++) {
+    for (uint8_t b = 0; b < FRAM_HIST_BUCKETS; b++) {
+      uint16_t c = _counts[op][b];
+      buffer[i++] = (uint8_t)(c & 0xFF);
+      buffer[i++] = (uint8_t)(c >> 8);
+    }
+  }
+  return i;
+}
+
+/*!
+ *  @brief  Prints one line per operation class: the name followed by the
+ *          non-empty buckets as "<upper bound us>:<count>"
+ *  @param  out
+ *          Where to print, e.g. Serial
+ */
+void Adafruit_FRAM_SPI_Histogram::printTo(Print &out) const {
+  for (uint8_t op = 0; op < FRAM_OP_CONTROL; op++) {
+    out.print(_op_names[op]);
+    for (uint8_t b = 0; b < FRAM_HIST_BUCKETS; b++) {
+      uint16_t c = _counts[op][b];
+      if (!c) {
+        continue;
+      }
+      out.print(' ');
+      if (b == FRAM_HIST_BUCKETS - 1) {
+        out.print(">=");
+        out.print(1UL << (b - 1));
+      } else {
+        out.print(b ? (1UL << b) - 1 : 0UL);
+      }
+      out.print(':');
+      out.print(c);
+    }
+    out.println();
+  }
+}
@@ -0,0 +1,53 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Histogram.h
+ *
+ *  Fixed-bucket latency histograms for Adafruit_FRAM_SPI operations.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_HISTOGRAM_H_
+#define _ADAFRUIT_FRAM_SPI_HISTOGRAM_H_
+
+#include <Arduino.h>
+
+/// Buckets per operation; bucket n holds latencies in [2^(n-1), 2^n) us
+#define FRAM_HIST_BUCKETS 16
+
+/// Size in bytes of the binary dump produced by serialize()
+#define FRAM_HIST_SERIALIZED_SIZE (4 + FRAM_OP_CONTROL * FRAM_HIST_BUCKETS * 2)
+
+/** Operation classes seen by the driver's instrumentation **/
+typedef enum fram_op_e {
+  FRAM_OP_READ,    /* read() */
+  FRAM_OP_WRITE,   /* write() */
+  FRAM_OP_READ8,   /* read8() */
+  FRAM_OP_WRITE8,  /* write8() */
+  FRAM_OP_STATUS,  /* getStatusRegister() / setStatusRegister() */
+  FRAM_OP_WAKE,    /* Recovery from sleep */
+  FRAM_OP_CONTROL, /* WREN/WRDI/RDID/SLEEP, not histogrammed */
+  FRAM_OP_CLASSES  /* Number of classes */
+} fram_op_t;
+
+/*!
+ *  @brief  Log2 latency histograms, one row per timed operation class.
+ *          Meant to be declared static; counters saturate at 65535 and may
+ *          be updated from interrupts or other threads.
+ */
+class Adafruit_FRAM_SPI_Histogram {
+public:
+  Adafruit_FRAM_SPI_Histogram(void);
+
+  void record(fram_op_t op, uint32_t micros);
+  void reset(void);
+  uint16_t count(fram_op_t op, uint8_t bucket) const;
+  static uint8_t bucketFor(uint32_t micros);
+
+  size_t serialize(uint8_t *buffer, size_t size) const;
+  void printTo(Print &out) const;
+
+private:
+  volatile uint16_t _counts[FRAM_OP_CONTROL][FRAM_HIST_BUCKETS];
+};
+
+#endif
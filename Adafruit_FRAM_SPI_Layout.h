@@ -0,0 +1,309 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Layout.h
+ *
+ *  Compile-time description of data laid out in an Adafruit_FRAM_SPI.
+ *  Fields get constexpr offsets, overlap and capacity are checked with
+ *  static_assert, and the typed accessors pass constant addresses to the
+ *  driver. C++11.
+ *
+ *      typedef Adafruit_FRAM_SPI_Field<Config, 0> ConfigField;
+ *      typedef Adafruit_FRAM_SPI_After<ConfigField, uint32_t, 16, 4> Counters;
+ *      typedef Adafruit_FRAM_SPI_After<Counters, Sample, 100> Samples;
+ *      FRAM_LAYOUT_ASSERT(FRAM_CAPACITY_MB85RS64V, ConfigField, Counters,
+ *                         Samples);
+ *
+ *      Counters::write(fram, count, 3);
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_LAYOUT_H_
+#define _ADAFRUIT_FRAM_SPI_LAYOUT_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+// AVR toolchains ship no C++ standard library
+#if defined(__has_include)
+#if __has_include(<type_traits>)
+#include <type_traits>
+#define FRAM_SPI_HAS_TYPE_TRAITS 1
+#endif
+#endif
+
+#ifndef FRAM_SPI_IS_TRIVIAL
+#ifdef FRAM_SPI_HAS_TYPE_TRAITS
+/// True if T can be moved to and from FRAM as raw bytes
+#define FRAM_SPI_IS_TRIVIAL(T) std::is_trivially_copyable<T>::value
+#else
+/// True if T can be moved to and from FRAM as raw bytes (GCC/Clang builtin)
+#define FRAM_SPI_IS_TRIVIAL(T) __is_trivially_copyable(T)
+#endif
+#endif
+
+/** Capacities of the supported parts, for FRAM_LAYOUT_ASSERT **/
+#define FRAM_CAPACITY_MB85RS16 (2 * 1024UL)     ///< MB85RS16
+#define FRAM_CAPACITY_MB85RS64V (8 * 1024UL)    ///< MB85RS64V
+#define FRAM_CAPACITY_MB85RS64T (8 * 1024UL)    ///< MB85RS64T
+#define FRAM_CAPACITY_MB85RS256TY (32 * 1024UL) ///< MB85RS256TY
+#define FRAM_CAPACITY_MB85RS1MT (128 * 1024UL)  ///< MB85RS1MT
+#define FRAM_CAPACITY_MB85RS2MT (256 * 1024UL)  ///< MB85RS2MT, MB85RS2MTA
+#define FRAM_CAPACITY_MB85RS4MT (512 * 1024UL)  ///< MB85RS4MT, MB85RS4MTY
+#define FRAM_CAPACITY_FM25V02 (32 * 1024UL)     ///< FM25V02
+#define FRAM_CAPACITY_MR45V064B (8 * 1024UL)    ///< MR45V064B
+
+/*!
+ *  @brief  Rounds an offset up to an alignment
+ *  @param  offset
+ *          Byte offset
+ *  @param  align
+ *          Alignment in bytes, a power of two
+ *  @return Aligned offset
+ */
+constexpr uint32_t fram_layout_align(uint32_t offset, uint32_t align) {
+  return (offset + align - 1) & ~(align - 1);
+}
+
+/*!
+ *  @brief  Count elements of type T at a fixed FRAM address. All members
+ *          are static; use the type, not an instance.
+ *  @tparam T
+ *          Element type, trivially copyable
+ *  @tparam Offset
+ *          FRAM address of element 0
+ *  @tparam Count
+ *          Number of elements, 1 for a scalar field
+ */
+template <typename T, uint32_t Offset, uint32_t Count = 1>
+struct Adafruit_FRAM_SPI_Field {
+  static_assert(FRAM_SPI_IS_TRIVIAL(T),
+                "FRAM field type must be trivially copyable");
+  static_assert(Count <= (0xFFFFFFFFUL - Offset) / sizeof(T),
+                "FRAM field runs past the 32-bit address space");
+
+  typedef T type; ///< Element type
+  /// FRAM address of the first byte
+  static constexpr uint32_t offset = Offset;
+  /// Number of elements
+  static constexpr uint32_t count = Count;
+  /// Bytes used
+  static constexpr uint32_t size = sizeof(T) * Count;
+  /// FRAM address past the last byte
+  static constexpr uint32_t end = Offset + sizeof(T) * Count;
+
+  /*!
+   *  @brief  Address of an element
+   *  @param  index
+   *          Element index
+   *  @return FRAM address
+   */
+  static constexpr uint32_t addr(uint32_t index = 0) {
+    return Offset + index * sizeof(T);
+  }
+
+  /*!
+   *  @brief  Reads an element whose index is known at compile time
+   *  @tparam Index
+   *          Element index, checked against Count
+   *  @param  fram
+   *          Device
+   *  @param  value
+   *          Receives the element
+   *  @return true on success
+   */
+  template <uint32_t Index = 0>
+  static bool get(Adafruit_FRAM_SPI &fram, T *value) {
+    static_assert(Index < Count, "FRAM field index out of range");
+    return fram.read(Offset + Index * sizeof(T), (uint8_t *)value, sizeof(T));
+  }
+
+  /*!
+   *  @brief  Writes an element whose index is known at compile time
+   *  @tparam Index
+   *          Element index, checked against Count
+   *  @param  fram
+   *          Device
+   *  @param  value
+   *          New value
+   *  @return true on success
+   */
+  template <uint32_t Index = 0>
+  static bool set(Adafruit_FRAM_SPI &fram, const T &value) {
+    static_assert(Index < Count, "FRAM field index out of range");
+    return fram.writeEnable(true) &&
+           fram.write(Offset + Index * sizeof(T), (const uint8_t *)&value,
+                      sizeof(T));
+  }
+
+  /*!
+   *  @brief  Reads an element
+   *  @param  fram
+   *          Device
+   *  @param  value
+   *          Receives the element
+   *  @param  index
+   *          Element index
+   *  @return true on success, false if index is out of range
+   */
+  static bool read(Adafruit_FRAM_SPI &fram, T *value, uint32_t index = 0) {
+    return index < Count &&
+           fram.read(addr(index), (uint8_t *)value, sizeof(T));
+  }
+
+  /*!
+   *  @brief  Writes an element
+   *  @param  fram
+   *          Device
+   *  @param  value
+   *          New value
+   *  @param  index
+   *          Element index
+   *  @return true on success, false if index is out of range
+   */
+  static bool write(Adafruit_FRAM_SPI &fram, const T &value,
+                    uint32_t index = 0) {
+    return index < Count && fram.writeEnable(true) &&
+           fram.write(addr(index), (const uint8_t *)&value, sizeof(T));
+  }
+
+  /*!
+   *  @brief  Reads every element in one burst
+   *  @param  fram
+   *          Device
+   *  @param  values
+   *          Receives Count elements
+   *  @return true on success
+   */
+  static bool readAll(Adafruit_FRAM_SPI &fram, T *values) {
+    return fram.read(Offset, (uint8_t *)values, size);
+  }
+
+  /*!
+   *  @brief  Writes every element in one burst
+   *  @param  fram
+   *          Device
+   *  @param  values
+   *          Count elements
+   *  @return true on success
+   */
+  static bool writeAll(Adafruit_FRAM_SPI &fram, const T *values) {
+    return fram.writeEnable(true) &&
+           fram.write(Offset, (const uint8_t *)values, size);
+  }
+};
+
+template <typename T, uint32_t Offset, uint32_t Count>
+constexpr uint32_t Adafruit_FRAM_SPI_Field<T, Offset, Count>::offset;
+template <typename T, uint32_t Offset, uint32_t Count>
+constexpr uint32_t Adafruit_FRAM_SPI_Field<T, Offset, Count>::count;
+template <typename T, uint32_t Offset, uint32_t Count>
+constexpr uint32_t Adafruit_FRAM_SPI_Field<T, Offset, Count>::size;
+template <typename T, uint32_t Offset, uint32_t Count>
+constexpr uint32_t Adafruit_FRAM_SPI_Field<T, Offset, Count>::end;
+
+/*!
+ *  @brief  A field placed right after another one
+ *  @tparam Prev
+ *          Field this one follows
+ *  @tparam T
+ *          Element type
+ *  @tparam Count
+ *          Number of elements
+ *  @tparam Align
+ *          Alignment of the start address, a power of two
+ */
+template <typename Prev, typename T, uint32_t Count = 1, uint32_t Align = 1>
+struct Adafruit_FRAM_SPI_After
+    : Adafruit_FRAM_SPI_Field<T, fram_layout_align(Prev::end, Align), Count> {
+  static_assert(Align && !(Align & (Align - 1)),
+                "FRAM field alignment must be a power of two");
+  static_assert(Prev::end <= 0xFFFFFFFFUL - (Align - 1),
+                "FRAM field runs past the 32-bit address space");
+};
+
+/*!
+ *  @brief  Whether two fields share any byte
+ *  @tparam A
+ *          First field
+ *  @tparam B
+ *          Second field
+ *  @return true if they overlap
+ */
+template <typename A, typename B> constexpr bool fram_layout_overlap() {
+  return A::offset < B::end && B::offset < A::end;
+}
+
+/*!
+ *  @brief  A set of fields checked together at compile time
+ *  @tparam Fields
+ *          Field types
+ */
+template <typename... Fields> struct Adafruit_FRAM_SPI_Layout;
+
+/*!
+ *  @brief  Empty layout, ends the recursion
+ */
+template <> struct Adafruit_FRAM_SPI_Layout<> {
+  static constexpr uint32_t end = 0;     ///< Past the last byte used
+  static constexpr bool disjoint = true; ///< No two fields overlap
+
+  /*!
+   *  @brief  Whether a field overlaps none of the fields
+   *  @tparam F
+   *          Field to test
+   *  @return true if clear
+   */
+  template <typename F> static constexpr bool clearOf() { return true; }
+
+  /*!
+   *  @brief  Whether the layout fits a part
+   *  @param  capacity
+   *          Part size in bytes
+   *  @return true if every field lies below capacity
+   */
+  static constexpr bool fits(uint32_t capacity) { return end <= capacity; }
+};
+
+/*!
+ *  @brief  Layout of F followed by Rest
+ *  @tparam F
+ *          First field
+ *  @tparam Rest
+ *          Remaining fields
+ */
+template <typename F, typename... Rest>
+struct Adafruit_FRAM_SPI_Layout<F, Rest...> {
+  typedef Adafruit_FRAM_SPI_Layout<Rest...> tail; ///< Remaining fields
+
+  /// Past the last byte used
+  static constexpr uint32_t end = F::end > tail::end ? F::end : tail::end;
+  /// No two fields overlap
+  static constexpr bool disjoint =
+      tail::template clearOf<F>() && tail::disjoint;
+
+  /*!
+   *  @brief  Whether a field overlaps none of the fields
+   *  @tparam G
+   *          Field to test
+   *  @return true if clear
+   */
+  template <typename G> static constexpr bool clearOf() {
+    return !fram_layout_overlap<F, G>() && tail::template clearOf<G>();
+  }
+
+  /*!
+   *  @brief  Whether the layout fits a part
+   *  @param  capacity
+   *          Part size in bytes
+   *  @return true if every field lies below capacity
+   */
+  static constexpr bool fits(uint32_t capacity) { return end <= capacity; }
+};
+
+/// Fails the build if the fields overlap or do not fit capacity bytes
+#define FRAM_LAYOUT_ASSERT(capacity, ...)                                      \
+  static_assert(Adafruit_FRAM_SPI_Layout<__VA_ARGS__>::disjoint,               \
+                "FRAM layout fields overlap");                                 \
+  static_assert(Adafruit_FRAM_SPI_Layout<__VA_ARGS__>::fits(capacity),         \
+                "FRAM layout does not fit the part")
+
+#endif
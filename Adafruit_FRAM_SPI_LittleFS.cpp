@@ -0,0 +1,152 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_LittleFS.cpp
+ *
+ *  LittleFS block device binding for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_LittleFS.h"
+
+#ifdef FRAM_SPI_HAS_LITTLEFS
+
+/*!
+ *  @brief  Creates a block device over an FRAM region
+ *  @param  fram
+ *          Device holding the file system
+ *  @param  base
+ *          First byte of the region
+ *  @param  size
+ *          Region size in bytes, 0 for the rest of the device
+ */
+Adafruit_FRAM_SPI_LittleFS::Adafruit_FRAM_SPI_LittleFS(Adafruit_FRAM_SPI &fram,
+                                                       uint32_t base,
+                                                       uint32_t size)
+    : _fram(fram), _base(base), _size(size) {
+  memset(&_cfg, 0, sizeof(_cfg));
+}
+
+/*!
+ *  @brief  Fills in the lfs_config. Call after the FRAM's begin() and pass
+ *          config() to lfs_format()/lfs_mount().
+ *  @param  blockSize
+ *          Block size in bytes, 0 to pick one from the region size (256 B up
+ *          to 64 KB, 512 B above). The cache is a whole block, so every cache
+ *          fill or flush is one burst.
+ *  @return true if the region holds at least two blocks
+ */
+bool Adafruit_FRAM_SPI_LittleFS::begin(uint16_t blockSize) {
+  uint32_t size = _size;
+  uint32_t devSize = _fram.getSize();
+  if (!size && devSize > _base) {
+    size = devSize - _base;
+  }
+  if (!blockSize) {
+    blockSize = size > 64 * 1024UL ? 512 : 256;
+  }
+  if (!size || size / blockSize < 2) {
+    return false;
+  }
+
+  memset(&_cfg, 0, sizeof(_cfg));
+  _cfg.context = this;
+  _cfg.read = _read;
+  _cfg.prog = _prog;
+  _cfg.erase = _erase;
+  _cfg.sync = _sync;
+  _cfg.read_size = 1;
+  _cfg.prog_size = 1;
+  _cfg.block_size = blockSize;
+  _cfg.block_count = size / blockSize;
+#if LFS_VERSION >= 0x00020000
+  _cfg.cache_size = blockSize;
+  _cfg.lookahead_size = 16;
+  // FRAM endurance makes wear leveling pointless, skip the block moves
+  _cfg.block_cycles = -1;
+#else
+  _cfg.lookahead = 128;
+#endif
+  return true;
+}
+
+/*!
+ *  @brief  Configuration to hand to lfs_format()/lfs_mount()
+ *  @return The config filled in by begin()
+ */
+struct lfs_config *Adafruit_FRAM_SPI_LittleFS::config(void) { return &_cfg; }
+
+/*!
+ *  @brief  lfs read callback, one burst per call
+ *  @param  c
+ *          Config, context points at the adapter
+ *  @param  block
+ *          Block number
+ *  @param  off
+ *          Offset within the block
+ *  @param  buffer
+ *          Destination
+ *  @param  size
+ *          Bytes to read
+ *  @return 0 on success, LFS_ERR_IO on a bus error
+ */
+int Adafruit_FRAM_SPI_LittleFS::_read(const struct lfs_config *c,
+                                      lfs_block_t block, lfs_off_t off,
+                                      void *buffer, lfs_size_t size) {
+  Adafruit_FRAM_SPI_LittleFS *self = (Adafruit_FRAM_SPI_LittleFS *)c->context;
+  uint32_t addr = self->_base + block * c->block_size + off;
+  return self->_fram.read(addr, (uint8_t *)buffer, size) ? 0 : LFS_ERR_IO;
+}
+
+/*!
+ *  @brief  lfs prog callback: WREN then one WRITE burst
+ *  @param  c
+ *          Config, context points at the adapter
+ *  @param  block
+ *          Block number
+ *  @param  off
+ *          Offset within the block
+ *  @param  buffer
+ *          Data to program
+ *  @param  size
+ *          Bytes to program
+ *  @return 0 on success, LFS_ERR_IO on a bus error
+ */
+int Adafruit_FRAM_SPI_LittleFS::_prog(const struct lfs_config *c,
+                                      lfs_block_t block, lfs_off_t off,
+                                      const void *buffer, lfs_size_t size) {
+  Adafruit_FRAM_SPI_LittleFS *self = (Adafruit_FRAM_SPI_LittleFS *)c->context;
+  uint32_t addr = self->_base + block * c->block_size + off;
+  if (!self->_fram.writeEnable(true) ||
+      !self->_fram.write(addr, (const uint8_t *)buffer, size)) {
+    return LFS_ERR_IO;
+  }
+  return 0;
+}
+
+/*!
+ *  @brief  lfs erase callback; FRAM is written in place, nothing to do
+ *  @param  c
+ *          Config
+ *  @param  block
+ *          Block number
+ *  @return 0
+ */
+int Adafruit_FRAM_SPI_LittleFS::_erase(const struct lfs_config *c,
+                                       lfs_block_t block) {
+  (void)c;
+  (void)block;
+  return 0;
+}
+
+/*!
+ *  @brief  lfs sync callback; FRAM writes are durable when the burst ends
+ *  @param  c
+ *          Config
+ *  @return 0
+ */
+int Adafruit_FRAM_SPI_LittleFS::_sync(const struct lfs_config *c) {
+  (void)c;
+  return 0;
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_LittleFS.h
+ *
+ *  LittleFS block device binding for Adafruit_FRAM_SPI. Only built when the
+ *  littlefs headers (lfs.h) are available, e.g. on the Adafruit nRF52 core or
+ *  with a LittleFS library installed.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_LITTLEFS_H_
+#define _ADAFRUIT_FRAM_SPI_LITTLEFS_H_
+
+#if defined(__has_include)
+#if __has_include(<lfs.h>)
+#define FRAM_SPI_HAS_LITTLEFS 1
+#endif
+#endif
+
+#ifdef FRAM_SPI_HAS_LITTLEFS
+
+#include "Adafruit_FRAM_SPI.h"
+#include <lfs.h>
+
+/*!
+ *  @brief  Presents an FRAM region as a LittleFS block device. FRAM needs
+ *          no erase and writes at byte granularity, so erase is a no-op,
+ *          read and program sizes are 1 byte, and each cache fill or flush
+ *          is a single burst of a whole block.
+ */
+class Adafruit_FRAM_SPI_LittleFS {
+public:
+  Adafruit_FRAM_SPI_LittleFS(Adafruit_FRAM_SPI &fram, uint32_t base = 0,
+                             uint32_t size = 0);
+
+  bool begin(uint16_t blockSize = 0);
+  struct lfs_config *config(void);
+
+private:
+  static int _read(const struct lfs_config *c, lfs_block_t block,
+                   lfs_off_t off, void *buffer, lfs_size_t size);
+  static int _prog(const struct lfs_config *c, lfs_block_t block,
+                   lfs_off_t off, const void *buffer, lfs_size_t size);
+  static int _erase(const struct lfs_config *c, lfs_block_t block);
+  static int _sync(const struct lfs_config *c);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size;
+  struct lfs_config _cfg;
+};
+
+#endif
+
+#endif
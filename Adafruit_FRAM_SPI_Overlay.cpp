@@ -0,0 +1,247 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Overlay.cpp
+ *
+ *  Overlay manager paging objects between an FRAM region and a RAM pool.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Overlay.h"
+
+/*!
+ *  @brief  Creates an overlay manager
+ *  @param  fram
+ *          Device holding the objects, already begun
+ *  @param  base
+ *          First byte of the object region
+ *  @param  size
+ *          Region size in bytes
+ *  @param  pool
+ *          RAM frames, owned by the caller and aligned for the objects
+ *  @param  poolSize
+ *          Size of pool in bytes
+ *  @param  frameSize
+ *          Bytes per frame, the largest object that can be allocated;
+ *          keep it a multiple of the objects' alignment
+ */
+Adafruit_FRAM_SPI_Overlay::Adafruit_FRAM_SPI_Overlay(
+    Adafruit_FRAM_SPI &fram, uint32_t base, uint32_t size, uint8_t *pool,
+    uint16_t poolSize, uint16_t frameSize)
+    : _fram(fram), _base(base), _size(size), _pool(pool),
+      _frameSize(frameSize) {
+  uint16_t frames = (pool && frameSize) ? poolSize / frameSize : 0;
+  _frames = frames > FRAM_OVERLAY_MAX_FRAMES ? FRAM_OVERLAY_MAX_FRAMES
+                                             : frames;
+  reset();
+}
+
+/*!
+ *  @brief  Forgets every object and resident frame, without writing
+ *          anything back, and clears the counters
+ */
+void Adafruit_FRAM_SPI_Overlay::reset(void) {
+  _next = 0;
+  _resident = 0;
+  _dirty = 0;
+  _clock = 0;
+  memset(_pins, 0, sizeof(_pins));
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/*!
+ *  @brief  Allocates an object in the region. Its initial contents are
+ *          whatever the FRAM held.
+ *  @param  size
+ *          Object size in bytes, at most the frame size
+ *  @return Handle, with size 0 if the object does not fit
+ */
+fram_overlay_handle_t Adafruit_FRAM_SPI_Overlay::alloc(uint16_t size) {
+  fram_overlay_handle_t h = {0, 0};
+  if (!size || size > _frameSize || size > available()) {
+    return h;
+  }
+  h.addr = _base + _next;
+  h.size = size;
+  _next += size;
+  return h;
+}
+
+/*!
+ *  @brief  Free space left in the region
+ *  @return Bytes that can still be allocated
+ */
+uint32_t Adafruit_FRAM_SPI_Overlay::available(void) const {
+  return _size - _next;
+}
+
+/*!
+ *  @brief  Finds the frame holding an object
+ *  @param  addr
+ *          Object address
+ *  @return Frame index, -1 if not resident
+ */
+int8_t Adafruit_FRAM_SPI_Overlay::find(uint32_t addr) {
+  for (uint8_t f = 0; f < _frames; f++) {
+    if ((_resident & (1 << f)) && _addr[f] == addr) {
+      return f;
+    }
+  }
+  return -1;
+}
+
+/*!
+ *  @brief  Frees a frame: an empty one if any, otherwise the least
+ *          recently used unpinned one, written back first if dirty
+ *  @return Frame index, -1 if every frame is pinned or write-back failed
+ */
+int8_t Adafruit_FRAM_SPI_Overlay::claim(void) {
+  int8_t victim = -1;
+  for (uint8_t f = 0; f < _frames; f++) {
+    if (!(_resident & (1 << f))) {
+      return f;
+    }
+    if (_pins[f]) {
+      continue;
+    }
+    if (victim < 0 || (uint16_t)(_clock - _stamp[f]) >
+                          (uint16_t)(_clock - _stamp[victim])) {
+      victim = f;
+    }
+  }
+  if (victim < 0 || !writeBack(victim)) {
+    return -1;
+  }
+  _resident &= ~(1 << victim);
+  return victim;
+}
+
+/*!
+ *  @brief  Writes a frame back if it is dirty
+ *  @param  f
+ *          Frame index
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Overlay::writeBack(uint8_t f) {
+  if (!(_dirty & (1 << f))) {
+    return true;
+  }
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_addr[f], _pool + f * _frameSize, _len[f])) {
+    return false;
+  }
+  _dirty &= ~(1 << f);
+  _stats.writebacks++;
+  return true;
+}
+
+/*!
+ *  @brief  Reads an object into a claimed frame
+ *  @param  f
+ *          Frame index
+ *  @param  h
+ *          Object handle
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Overlay::load(uint8_t f, fram_overlay_handle_t h) {
+  if (!_fram.read(h.addr, _pool + f * _frameSize, h.size)) {
+    return false;
+  }
+  _addr[f] = h.addr;
+  _len[f] = h.size;
+  _pins[f] = 0;
+  _stamp[f] = ++_clock;
+  _resident |= 1 << f;
+  return true;
+}
+
+/*!
+ *  @brief  Makes an object resident and pins it. The pointer stays valid
+ *          until the matching unpin(); pins nest.
+ *  @param  h
+ *          Object handle from alloc()
+ *  @param  write
+ *          true if the object will be modified, so it is written back
+ *          when evicted or flushed
+ *  @return Pointer to the RAM copy, NULL if the handle is invalid, every
+ *          frame is pinned, or the bus failed
+ */
+void *Adafruit_FRAM_SPI_Overlay::pin(fram_overlay_handle_t h, bool write) {
+  if (!h.size || h.size > _frameSize) {
+    _stats.failures++;
+    return NULL;
+  }
+  int8_t f = find(h.addr);
+  if (f >= 0) {
+    _stats.hits++;
+    _stamp[f] = ++_clock;
+  } else {
+    f = claim();
+    if (f < 0 || !load(f, h)) {
+      _stats.failures++;
+      return NULL;
+    }
+    _stats.misses++;
+  }
+  if (_pins[f] < 0xFF) {
+    _pins[f]++;
+  }
+  if (write) {
+    _dirty |= 1 << f;
+  }
+  return _pool + f * _frameSize;
+}
+
+/*!
+ *  @brief  Releases a pin. Unpinned frames may be evicted.
+ *  @param  h
+ *          Object handle
+ *  @param  dirty
+ *          true if the object was modified through a read-only pin
+ */
+void Adafruit_FRAM_SPI_Overlay::unpin(fram_overlay_handle_t h, bool dirty) {
+  int8_t f = find(h.addr);
+  if (f < 0) {
+    return;
+  }
+  if (_pins[f]) {
+    _pins[f]--;
+  }
+  if (dirty) {
+    _dirty |= 1 << f;
+  }
+}
+
+/*!
+ *  @brief  Hints that an object will be pinned soon. Reads it in now if a
+ *          frame can be had, so the later pin() is a hit; the object is not
+ *          pinned and may still be evicted.
+ *  @param  h
+ *          Object handle
+ *  @return true if the object is now resident
+ */
+bool Adafruit_FRAM_SPI_Overlay::prefetch(fram_overlay_handle_t h) {
+  if (!h.size || h.size > _frameSize) {
+    return false;
+  }
+  if (find(h.addr) >= 0) {
+    return true;
+  }
+  int8_t f = claim();
+  if (f < 0 || !load(f, h)) {
+    return false;
+  }
+  _stats.prefetches++;
+  return true;
+}
+
+/*!
+ *  @brief  Writes back every dirty frame; frames stay resident
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Overlay::flush(void) {
+  bool ok = true;
+  for (uint8_t f = 0; f < _frames; f++) {
+    ok = writeBack(f) && ok;
+  }
+  return ok;
+}
@@ -0,0 +1,98 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Overlay.h
+ *
+ *  Overlay manager paging objects between an FRAM region and a RAM pool.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_OVERLAY_H_
+#define _ADAFRUIT_FRAM_SPI_OVERLAY_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/// Most RAM frames an overlay manager can track
+#define FRAM_OVERLAY_MAX_FRAMES 8
+
+/*!
+ *  @brief  Handle to an object living in FRAM
+ */
+typedef struct {
+  uint32_t addr; ///< FRAM address of the object
+  uint16_t size; ///< Object size in bytes, 0 for an invalid handle
+} fram_overlay_handle_t;
+
+/*!
+ *  @brief  Paging counters, to measure the bus cost of the overlay
+ */
+typedef struct {
+  uint32_t hits;       ///< pin() found the object resident
+  uint32_t misses;     ///< pin() had to read the object in
+  uint32_t prefetches; ///< Objects read in by prefetch()
+  uint32_t writebacks; ///< Dirty frames written back
+  uint32_t failures;   ///< pin() calls that returned NULL
+} fram_overlay_stats_t;
+
+/*!
+ *  @brief  Keeps objects in FRAM and pages them into a fixed pool of RAM
+ *          frames on access. pin() returns a RAM copy that stays put until
+ *          the matching unpin(); unpinned frames are evicted least recently
+ *          used first, dirty ones written back in one burst. Objects are
+ *          allocated from the region with a bump allocator and must fit in
+ *          a frame.
+ */
+class Adafruit_FRAM_SPI_Overlay {
+public:
+  Adafruit_FRAM_SPI_Overlay(Adafruit_FRAM_SPI &fram, uint32_t base,
+                            uint32_t size, uint8_t *pool, uint16_t poolSize,
+                            uint16_t frameSize);
+
+  fram_overlay_handle_t alloc(uint16_t size);
+  void reset(void);
+  uint32_t available(void) const;
+
+  void *pin(fram_overlay_handle_t h, bool write = false);
+  void unpin(fram_overlay_handle_t h, bool dirty = false);
+  bool prefetch(fram_overlay_handle_t h);
+  bool flush(void);
+
+  /*!
+   *  @brief  Pins an object as a T
+   *  @param  h
+   *          Object handle, at least sizeof(T) bytes
+   *  @param  write
+   *          true if the object will be modified
+   *  @return Pointer to the RAM copy, NULL on failure
+   */
+  template <typename T> T *pinAs(fram_overlay_handle_t h, bool write = false) {
+    return h.size >= sizeof(T) ? (T *)pin(h, write) : NULL;
+  }
+
+  /*!
+   *  @brief  Paging counters
+   *  @return Counters since construction or the last reset()
+   */
+  const fram_overlay_stats_t &stats(void) const { return _stats; }
+
+private:
+  int8_t find(uint32_t addr);
+  int8_t claim(void);
+  bool writeBack(uint8_t f);
+  bool load(uint8_t f, fram_overlay_handle_t h);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size, _next;
+  uint8_t *_pool;
+  uint16_t _frameSize;
+  uint8_t _frames;
+  uint8_t _resident; // Bit per frame holding an object
+  uint8_t _dirty;    // Bit per frame needing write-back
+  uint16_t _clock;
+  uint32_t _addr[FRAM_OVERLAY_MAX_FRAMES];
+  uint16_t _len[FRAM_OVERLAY_MAX_FRAMES];
+  uint16_t _stamp[FRAM_OVERLAY_MAX_FRAMES];
+  uint8_t _pins[FRAM_OVERLAY_MAX_FRAMES];
+  fram_overlay_stats_t _stats;
+};
+
+#endif
@@ -0,0 +1,380 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Partition.cpp
+ *
+ *  Partition table for sharing one Adafruit_FRAM_SPI between modules.
+ *
+ *  Table layout, little-endian: a 10-byte header {'F', 'P', version, count,
+ *  layoutVersion(16), alignShift, 0, CRC-16}, then count 16-byte entries
+ *  {name[8], offset, size}. The CRC covers header bytes 0-7 and the entries.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Partition.h"
+#include "Adafruit_FRAM_SPI_CRC.h"
+
+/// Table format version
+#define FRAM_PARTITION_VERSION 1
+
+static void put32(uint8_t *buf, uint32_t value) {
+  buf[0] = (uint8_t)(value & 0xFF);
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *buf) {
+  return buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+// CRC of a table image: header bytes 0-7, then buf[3] entries
+static uint16_t tableCrc(const uint8_t *buf) {
+  return crc16(crc16(0xFFFF, buf, 8), buf + 10, 16 * buf[3]);
+}
+
+/*!
+ *  @brief  Creates a handle; default-constructed handles are invalid
+ *  @param  table
+ *          Owning table
+ *  @param  index
+ *          Partition index in the table
+ */
+Adafruit_FRAM_SPI_Partition::Adafruit_FRAM_SPI_Partition(
+    Adafruit_FRAM_SPI_PartitionTable *table, uint8_t index)
+    : _table(table), _index(index) {}
+
+/*!
+ *  @brief  Whether the handle names a partition
+ *  @return true if usable
+ */
+bool Adafruit_FRAM_SPI_Partition::valid(void) const {
+  return _table && _index < _table->_count;
+}
+
+/*!
+ *  @brief  Partition name
+ *  @return NUL-terminated name, "" for an invalid handle
+ */
+const char *Adafruit_FRAM_SPI_Partition::name(void) const {
+  return valid() ? _table->_parts[_index].name : "";
+}
+
+/*!
+ *  @brief  Partition size
+ *  @return Size in bytes, 0 for an invalid handle
+ */
+uint32_t Adafruit_FRAM_SPI_Partition::size(void) const {
+  return valid() ? _table->_parts[_index].size : 0;
+}
+
+/*!
+ *  @brief  Where the partition starts on the device
+ *  @return Device address, 0 for an invalid handle
+ */
+uint32_t Adafruit_FRAM_SPI_Partition::offset(void) const {
+  return valid() ? _table->_parts[_index].offset : 0;
+}
+
+/*!
+ *  @brief  Checks that [off, off + len) lies inside the partition, counting
+ *          a rejection if not
+ *  @param  off
+ *          Offset into the partition
+ *  @param  len
+ *          Number of bytes
+ *  @return true if in bounds
+ */
+bool Adafruit_FRAM_SPI_Partition::check(uint32_t off, size_t len) {
+  if (!valid()) {
+    return false;
+  }
+  uint32_t size = _table->_parts[_index].size;
+  if (off > size || len > size - off) {
+    _table->_stats[_index].rejected++;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Reads from the partition
+ *  @param  off
+ *          Offset into the partition
+ *  @param  buf
+ *          Destination
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success, false if out of bounds or on a bus error
+ */
+bool Adafruit_FRAM_SPI_Partition::read(uint32_t off, uint8_t *buf,
+                                       size_t len) {
+  if (!check(off, len)) {
+    return false;
+  }
+  fram_partition_stats_t &s = _table->_stats[_index];
+  s.reads++;
+  s.readBytes += len;
+  return _table->_fram.read(_table->_parts[_index].offset + off, buf, len);
+}
+
+/*!
+ *  @brief  Writes to the partition, enabling writes first
+ *  @param  off
+ *          Offset into the partition
+ *  @param  data
+ *          Data to write
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success, false if out of bounds or on a bus error
+ */
+bool Adafruit_FRAM_SPI_Partition::write(uint32_t off, const uint8_t *data,
+                                        size_t len) {
+  if (!check(off, len)) {
+    return false;
+  }
+  fram_partition_stats_t &s = _table->_stats[_index];
+  s.writes++;
+  s.writeBytes += len;
+  return _table->_fram.writeEnable(true) &&
+         _table->_fram.write(_table->_parts[_index].offset + off, data, len);
+}
+
+/*!
+ *  @brief  Reads one byte from the partition
+ *  @param  off
+ *          Offset into the partition
+ *  @return Byte value, 0 if out of bounds
+ */
+uint8_t Adafruit_FRAM_SPI_Partition::read8(uint32_t off) {
+  uint8_t value = 0;
+  read(off, &value, 1);
+  return value;
+}
+
+/*!
+ *  @brief  Writes one byte to the partition
+ *  @param  off
+ *          Offset into the partition
+ *  @param  value
+ *          Byte to write
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Partition::write8(uint32_t off, uint8_t value) {
+  return write(off, &value, 1);
+}
+
+/*!
+ *  @brief  I/O counters of the partition
+ *  @return Counters, NULL for an invalid handle
+ */
+const fram_partition_stats_t *Adafruit_FRAM_SPI_Partition::stats(void) const {
+  return valid() ? &_table->_stats[_index] : NULL;
+}
+
+/*!
+ *  @brief  Creates a partition table
+ *  @param  fram
+ *          Device to partition
+ *  @param  tableAddr
+ *          Reserved address of the table, FRAM_PARTITION_TABLE_SIZE bytes
+ */
+Adafruit_FRAM_SPI_PartitionTable::Adafruit_FRAM_SPI_PartitionTable(
+    Adafruit_FRAM_SPI &fram, uint32_t tableAddr)
+    : _fram(fram), _tableAddr(tableAddr) {
+  _valid = false;
+  _count = 0;
+  _alignShift = 0;
+  _layout = 0;
+  resetStats();
+}
+
+/*!
+ *  @brief  Loads the table in one burst and caches it. Call after the
+ *          FRAM's own begin().
+ *  @return true if a valid table was found; if not, format() one
+ */
+bool Adafruit_FRAM_SPI_PartitionTable::begin(void) {
+  uint8_t buf[FRAM_PARTITION_TABLE_SIZE];
+  _valid = false;
+  _count = 0;
+  if (!_fram.read(_tableAddr, buf, sizeof(buf)) || buf[0] != 'F' ||
+      buf[1] != 'P' || buf[2] != FRAM_PARTITION_VERSION ||
+      buf[3] > FRAM_PARTITION_MAX || buf[6] > 24 ||
+      (buf[8] | (buf[9] << 8)) != tableCrc(buf)) {
+    return false;
+  }
+
+  // A table that passes its CRC but was written for a larger part, or
+  // whose entries cover the table itself, would let handles clobber it
+  uint32_t capacity = _fram.getSize();
+  uint32_t tableEnd = _tableAddr + FRAM_PARTITION_TABLE_SIZE;
+  for (uint8_t i = 0; i < buf[3]; i++) {
+    const uint8_t *e = buf + 10 + 16 * i;
+    uint32_t offset = get32(e + 8);
+    uint32_t size = get32(e + 12);
+    if (offset > capacity || size > capacity - offset ||
+        (offset < tableEnd && offset + size > _tableAddr)) {
+      return false;
+    }
+  }
+
+  _count = buf[3];
+  _layout = buf[4] | (buf[5] << 8);
+  _alignShift = buf[6];
+  for (uint8_t i = 0; i < _count; i++) {
+    const uint8_t *e = buf + 10 + 16 * i;
+    memcpy(_parts[i].name, e, FRAM_PARTITION_NAME);
+    _parts[i].name[FRAM_PARTITION_NAME] = 0;
+    _parts[i].offset = get32(e + 8);
+    _parts[i].size = get32(e + 12);
+  }
+  _valid = true;
+  return true;
+}
+
+/*!
+ *  @brief  Writes the cached table back in one burst
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_PartitionTable::save(void) {
+  uint8_t buf[FRAM_PARTITION_TABLE_SIZE];
+  memset(buf, 0, sizeof(buf));
+  for (uint8_t i = 0; i < _count; i++) {
+    uint8_t *e = buf + 10 + 16 * i;
+    strncpy((char *)e, _parts[i].name, FRAM_PARTITION_NAME);
+    put32(e + 8, _parts[i].offset);
+    put32(e + 12, _parts[i].size);
+  }
+  buf[0] = 'F';
+  buf[1] = 'P';
+  buf[2] = FRAM_PARTITION_VERSION;
+  buf[3] = _count;
+  buf[4] = (uint8_t)(_layout & 0xFF);
+  buf[5] = (uint8_t)(_layout >> 8);
+  buf[6] = _alignShift;
+  uint16_t crc = tableCrc(buf);
+  buf[8] = (uint8_t)(crc & 0xFF);
+  buf[9] = (uint8_t)(crc >> 8);
+  return _fram.writeEnable(true) &&
+         _fram.write(_tableAddr, buf, 10 + 16 * _count);
+}
+
+/*!
+ *  @brief  Starts an empty table, dropping every partition
+ *  @param  layoutVersion
+ *          Caller-defined version of the partition layout, so firmware can
+ *          detect and migrate an older one
+ *  @param  alignShift
+ *          log2 of the alignment of new partitions
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_PartitionTable::format(uint16_t layoutVersion,
+                                              uint8_t alignShift) {
+  if (alignShift > 24) {
+    return false;
+  }
+  _count = 0;
+  _layout = layoutVersion;
+  _alignShift = alignShift;
+  resetStats();
+  _valid = save();
+  return _valid;
+}
+
+/*!
+ *  @brief  Appends a partition after the last one (or after the table),
+ *          aligned as set by format()
+ *  @param  name
+ *          Unique name, at most FRAM_PARTITION_NAME characters
+ *  @param  size
+ *          Size in bytes
+ *  @return true if the partition was added and the table saved
+ */
+bool Adafruit_FRAM_SPI_PartitionTable::add(const char *name, uint32_t size) {
+  if (!_valid || _count >= FRAM_PARTITION_MAX || !size || !name ||
+      !*name || strlen(name) > FRAM_PARTITION_NAME || find(name).valid()) {
+    return false;
+  }
+  uint32_t start = _tableAddr + FRAM_PARTITION_TABLE_SIZE;
+  for (uint8_t i = 0; i < _count; i++) {
+    uint32_t end = _parts[i].offset + _parts[i].size;
+    if (end > start) {
+      start = end;
+    }
+  }
+  uint32_t align = 1UL << _alignShift;
+  start = (start + align - 1) & ~(align - 1);
+  uint32_t capacity = _fram.getSize();
+  if (start > capacity || size > capacity - start) {
+    return false;
+  }
+
+  fram_partition_t &p = _parts[_count];
+  memset(p.name, 0, sizeof(p.name));
+  strncpy(p.name, name, FRAM_PARTITION_NAME);
+  p.offset = start;
+  p.size = size;
+  memset(&_stats[_count], 0, sizeof(_stats[_count]));
+  _count++;
+  if (!save()) {
+    _count--;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Looks a partition up by name, in RAM
+ *  @param  name
+ *          Partition name
+ *  @return Handle, invalid if there is no such partition
+ */
+Adafruit_FRAM_SPI_Partition
+Adafruit_FRAM_SPI_PartitionTable::find(const char *name) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!strncmp(_parts[i].name, name, FRAM_PARTITION_NAME + 1)) {
+      return Adafruit_FRAM_SPI_Partition(this, i);
+    }
+  }
+  return Adafruit_FRAM_SPI_Partition();
+}
+
+/*!
+ *  @brief  Gets a partition by position
+ *  @param  index
+ *          Index, below count()
+ *  @return Handle, invalid if index is out of range
+ */
+Adafruit_FRAM_SPI_Partition
+Adafruit_FRAM_SPI_PartitionTable::get(uint8_t index) {
+  return index < _count ? Adafruit_FRAM_SPI_Partition(this, index)
+                        : Adafruit_FRAM_SPI_Partition();
+}
+
+/*!
+ *  @brief  Number of partitions
+ *  @return Partition count
+ */
+uint8_t Adafruit_FRAM_SPI_PartitionTable::count(void) const { return _count; }
+
+/*!
+ *  @brief  Layout version stored by format()
+ *  @return Layout version
+ */
+uint16_t Adafruit_FRAM_SPI_PartitionTable::layoutVersion(void) const {
+  return _layout;
+}
+
+/*!
+ *  @brief  Whether a table was loaded or formatted
+ *  @return true if partitions can be used and added
+ */
+bool Adafruit_FRAM_SPI_PartitionTable::valid(void) const { return _valid; }
+
+/*!
+ *  @brief  Clears the I/O counters of every partition
+ */
+void Adafruit_FRAM_SPI_PartitionTable::resetStats(void) {
+  memset(_stats, 0, sizeof(_stats));
+}
@@ -0,0 +1,111 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Partition.h
+ *
+ *  Partition table for sharing one Adafruit_FRAM_SPI between modules.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_PARTITION_H_
+#define _ADAFRUIT_FRAM_SPI_PARTITION_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/// Most partitions a table holds
+#ifndef FRAM_PARTITION_MAX
+#define FRAM_PARTITION_MAX 8
+#endif
+/// Longest partition name, not counting the terminator
+#define FRAM_PARTITION_NAME 8
+/// Bytes of FRAM reserved for the table
+#define FRAM_PARTITION_TABLE_SIZE (10 + 16 * FRAM_PARTITION_MAX)
+
+/*!
+ *  @brief  Per-partition I/O counters, kept in RAM
+ */
+typedef struct {
+  uint32_t reads;      ///< Read calls
+  uint32_t writes;     ///< Write calls
+  uint32_t readBytes;  ///< Bytes read
+  uint32_t writeBytes; ///< Bytes written
+  uint32_t rejected;   ///< Calls refused for leaving the partition
+} fram_partition_stats_t;
+
+/*!
+ *  @brief  One partition entry as cached from the table
+ */
+typedef struct {
+  char name[FRAM_PARTITION_NAME + 1]; ///< NUL-terminated name
+  uint32_t offset;                    ///< First byte on the device
+  uint32_t size;                      ///< Size in bytes
+} fram_partition_t;
+
+class Adafruit_FRAM_SPI_PartitionTable;
+
+/*!
+ *  @brief  Handle to a partition. Addresses are offsets into the
+ *          partition; accesses that would leave it are refused and
+ *          counted. Cheap to copy.
+ */
+class Adafruit_FRAM_SPI_Partition {
+public:
+  Adafruit_FRAM_SPI_Partition(Adafruit_FRAM_SPI_PartitionTable *table = NULL,
+                              uint8_t index = 0);
+
+  bool valid(void) const;
+  const char *name(void) const;
+  uint32_t size(void) const;
+  uint32_t offset(void) const;
+
+  bool read(uint32_t off, uint8_t *buf, size_t len);
+  bool write(uint32_t off, const uint8_t *data, size_t len);
+  uint8_t read8(uint32_t off);
+  bool write8(uint32_t off, uint8_t value);
+  const fram_partition_stats_t *stats(void) const;
+
+private:
+  bool check(uint32_t off, size_t len);
+
+  Adafruit_FRAM_SPI_PartitionTable *_table;
+  uint8_t _index;
+};
+
+/*!
+ *  @brief  Named partitions recorded in a small table at a reserved FRAM
+ *          address, with a format version, a caller-defined layout version
+ *          and an alignment for new partitions. begin() reads the whole
+ *          table in one burst and validates its CRC; lookups after that
+ *          touch only RAM.
+ */
+class Adafruit_FRAM_SPI_PartitionTable {
+public:
+  Adafruit_FRAM_SPI_PartitionTable(Adafruit_FRAM_SPI &fram,
+                                   uint32_t tableAddr = 0);
+
+  bool begin(void);
+  bool format(uint16_t layoutVersion, uint8_t alignShift = 0);
+  bool add(const char *name, uint32_t size);
+
+  Adafruit_FRAM_SPI_Partition find(const char *name);
+  Adafruit_FRAM_SPI_Partition get(uint8_t index);
+  uint8_t count(void) const;
+  uint16_t layoutVersion(void) const;
+  bool valid(void) const;
+  void resetStats(void);
+
+private:
+  friend class Adafruit_FRAM_SPI_Partition;
+
+  bool save(void);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _tableAddr;
+  bool _valid;
+  uint8_t _count;
+  uint8_t _alignShift;
+  uint16_t _layout;
+  fram_partition_t _parts[FRAM_PARTITION_MAX];
+  fram_partition_stats_t _stats[FRAM_PARTITION_MAX];
+};
+
+#endif
@@ -0,0 +1,233 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Queue.cpp
+ *
+ *  Thread-safe access to an Adafruit_FRAM_SPI through a lock-free
+ *  submission queue and a single I/O executor.
+ *
+ *  The queue is the intrusive MPSC queue described by Dmitry Vyukov:
+ *  producers exchange the tail pointer and then link the previous tail to
+ *  their node; the single consumer walks from the head and parks a stub
+ *  node when it catches up. extras/queue_stress runs it under std::thread
+ *  on a host.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Queue.h"
+
+#ifdef FRAM_SPI_HAS_ATOMIC
+
+#if __has_include(<thread>)
+#include <thread>
+#define FRAM_SPI_YIELD() std::this_thread::yield()
+#else
+#define FRAM_SPI_YIELD()
+#endif
+
+/*!
+ *  @brief  Creates a queue in front of a device. From then on only the
+ *          executor may call the device directly.
+ *  @param  fram
+ *          Device, begun before the executor starts
+ */
+Adafruit_FRAM_SPI_Queue::Adafruit_FRAM_SPI_Queue(Adafruit_FRAM_SPI &fram)
+    : _fram(fram) {
+  _stub.next.store(NULL, std::memory_order_relaxed);
+  _tail.store(&_stub, std::memory_order_relaxed);
+  _head = &_stub;
+}
+
+/*!
+ *  @brief  Links a node at the tail. Wait-free for producers.
+ *  @param  req
+ *          Node to append
+ */
+void Adafruit_FRAM_SPI_Queue::push(fram_spi_request_t *req) {
+  req->next.store(NULL, std::memory_order_relaxed);
+  fram_spi_request_t *prev = _tail.exchange(req, std::memory_order_acq_rel);
+  prev->next.store(req, std::memory_order_release);
+}
+
+/*!
+ *  @brief  Unlinks the oldest node. Executor only.
+ *  @return Node, or NULL if the queue is empty or a producer is midway
+ *          through push()
+ */
+fram_spi_request_t *Adafruit_FRAM_SPI_Queue::pop(void) {
+  fram_spi_request_t *head = _head;
+  fram_spi_request_t *next = head->next.load(std::memory_order_acquire);
+  if (head == &_stub) {
+    if (!next) {
+      return NULL;
+    }
+    _head = next;
+    head = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next) {
+    _head = next;
+    return head;
+  }
+  if (head != _tail.load(std::memory_order_acquire)) {
+    return NULL;
+  }
+  push(&_stub);
+  next = head->next.load(std::memory_order_acquire);
+  if (next) {
+    _head = next;
+    return head;
+  }
+  return NULL;
+}
+
+/*!
+ *  @brief  Queues a request. Safe from any thread; never blocks.
+ *  @param  req
+ *          Request with op, addr, data, len (or fn, arg) and complete set
+ *  @return false if the request is already queued
+ */
+bool Adafruit_FRAM_SPI_Queue::submit(fram_spi_request_t *req) {
+  if (req->state.load(std::memory_order_acquire) == FRAM_REQ_QUEUED) {
+    return false;
+  }
+  req->ok = false;
+  req->state.store(FRAM_REQ_QUEUED, std::memory_order_relaxed);
+  push(req);
+  return true;
+}
+
+/*!
+ *  @brief  Whether a request has finished
+ *  @param  req
+ *          Submitted request
+ *  @return true once the executor is done with it
+ */
+bool Adafruit_FRAM_SPI_Queue::done(const fram_spi_request_t *req) {
+  return req->state.load(std::memory_order_acquire) == FRAM_REQ_DONE;
+}
+
+/*!
+ *  @brief  Waits, yielding, for a request to finish
+ *  @param  req
+ *          Submitted request
+ *  @return Its result
+ */
+bool Adafruit_FRAM_SPI_Queue::wait(fram_spi_request_t *req) {
+  while (!done(req)) {
+    FRAM_SPI_YIELD();
+  }
+  req->state.store(FRAM_REQ_IDLE, std::memory_order_relaxed);
+  return req->ok;
+}
+
+/*!
+ *  @brief  Runs one request against the device
+ *  @param  req
+ *          Request popped from the queue
+ */
+void Adafruit_FRAM_SPI_Queue::execute(fram_spi_request_t *req) {
+  switch (req->op) {
+  case FRAM_REQ_READ:
+    req->ok = _fram.read(req->addr, req->data, req->len);
+    break;
+  case FRAM_REQ_WRITE:
+    req->ok = _fram.writeEnable(true) &&
+              _fram.write(req->addr, req->data, req->len);
+    break;
+  case FRAM_REQ_CALL:
+    req->ok = req->fn && req->fn(_fram, req->arg);
+    break;
+  default:
+    req->ok = false;
+    break;
+  }
+  // Read complete before publishing: a waiter may reuse req right after
+  void (*complete)(fram_spi_request_t *) = req->complete;
+  req->state.store(FRAM_REQ_DONE, std::memory_order_release);
+  if (complete) {
+    // Last access, so the owner may release req from inside complete
+    complete(req);
+  }
+}
+
+/*!
+ *  @brief  Executor step: runs queued requests in submission order. Call
+ *          from the one task that owns the bus.
+ *  @param  max
+ *          Most requests to run, 0 for all that are queued
+ *  @return Number of requests run
+ */
+uint32_t Adafruit_FRAM_SPI_Queue::poll(uint32_t max) {
+  uint32_t n = 0;
+  fram_spi_request_t *req;
+  while ((!max || n < max) && (req = pop()) != NULL) {
+    execute(req);
+    n++;
+  }
+  return n;
+}
+
+/*!
+ *  @brief  Reads through the executor and waits for the result
+ *  @param  addr
+ *          FRAM address
+ *  @param  buf
+ *          Destination
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Queue::read(uint32_t addr, uint8_t *buf, size_t len) {
+  fram_spi_request_t req;
+  req.op = FRAM_REQ_READ;
+  req.addr = addr;
+  req.data = buf;
+  req.len = len;
+  req.complete = NULL;
+  req.state.store(FRAM_REQ_IDLE, std::memory_order_relaxed);
+  return submit(&req) && wait(&req);
+}
+
+/*!
+ *  @brief  Writes through the executor and waits for the result
+ *  @param  addr
+ *          FRAM address
+ *  @param  data
+ *          Data to write
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Queue::write(uint32_t addr, const uint8_t *data,
+                                    size_t len) {
+  fram_spi_request_t req;
+  req.op = FRAM_REQ_WRITE;
+  req.addr = addr;
+  req.data = (uint8_t *)data;
+  req.len = len;
+  req.complete = NULL;
+  req.state.store(FRAM_REQ_IDLE, std::memory_order_relaxed);
+  return submit(&req) && wait(&req);
+}
+
+/*!
+ *  @brief  Runs any other driver call on the executor and waits for it,
+ *          e.g. a status register update or entering a low-power mode
+ *  @param  fn
+ *          Function run with the device
+ *  @param  arg
+ *          Passed to fn
+ *  @return What fn returned
+ */
+bool Adafruit_FRAM_SPI_Queue::call(bool (*fn)(Adafruit_FRAM_SPI &, void *),
+                                   void *arg) {
+  fram_spi_request_t req;
+  req.op = FRAM_REQ_CALL;
+  req.fn = fn;
+  req.arg = arg;
+  req.complete = NULL;
+  req.state.store(FRAM_REQ_IDLE, std::memory_order_relaxed);
+  return submit(&req) && wait(&req);
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Queue.h
+ *
+ *  Thread-safe access to an Adafruit_FRAM_SPI through a lock-free
+ *  submission queue and a single I/O executor. Only built where the
+ *  toolchain provides <atomic> (RTOS and host builds).
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_QUEUE_H_
+#define _ADAFRUIT_FRAM_SPI_QUEUE_H_
+
+#if defined(__has_include)
+#if __has_include(<atomic>)
+#define FRAM_SPI_HAS_ATOMIC 1
+#endif
+#endif
+
+#ifdef FRAM_SPI_HAS_ATOMIC
+
+#include "Adafruit_FRAM_SPI.h"
+#include <atomic>
+
+/** Request kinds **/
+typedef enum fram_spi_req_op_e {
+  FRAM_REQ_READ,  /* Read len bytes at addr into data */
+  FRAM_REQ_WRITE, /* WREN, then write len bytes from data at addr */
+  FRAM_REQ_CALL   /* Run fn(fram, arg) on the executor */
+} fram_spi_req_op_t;
+
+/** Request states **/
+typedef enum fram_spi_req_state_e {
+  FRAM_REQ_IDLE,   /* Not submitted, or reaped */
+  FRAM_REQ_QUEUED, /* Waiting for the executor */
+  FRAM_REQ_DONE    /* Finished; ok holds the result */
+} fram_spi_req_state_t;
+
+/*!
+ *  @brief  One request, owned by the submitting task and left untouched
+ *          until it is done
+ */
+struct fram_spi_request_t {
+  fram_spi_req_op_t op;                    ///< What to do
+  uint32_t addr;                           ///< FRAM address
+  uint8_t *data;                           ///< Buffer for read or write
+  size_t len;                              ///< Bytes to move
+  bool (*fn)(Adafruit_FRAM_SPI &, void *); ///< FRAM_REQ_CALL body
+  void *arg;                               ///< Argument for fn
+  void (*complete)(fram_spi_request_t *);  ///< Optional, run last when done
+  void *user;                              ///< Free for complete to use
+  bool ok;                                 ///< Result, valid once done
+  std::atomic<uint8_t> state;              ///< fram_spi_req_state_t
+  std::atomic<fram_spi_request_t *> next;  ///< Queue link
+};
+
+/*!
+ *  @brief  Serializes every access to one FRAM from many tasks without a
+ *          lock. Producers on any thread submit() requests to an intrusive
+ *          lock-free multi-producer, single-consumer queue; one executor
+ *          task calls poll() and is the only caller of the driver, so bus
+ *          transfers never run under a lock and never interleave. The
+ *          blocking read()/write()/call() helpers submit and then wait, and
+ *          must not be called from the executor itself.
+ */
+class Adafruit_FRAM_SPI_Queue {
+public:
+  Adafruit_FRAM_SPI_Queue(Adafruit_FRAM_SPI &fram);
+
+  bool submit(fram_spi_request_t *req);
+  static bool done(const fram_spi_request_t *req);
+  static bool wait(fram_spi_request_t *req);
+
+  uint32_t poll(uint32_t max = 0);
+
+  bool read(uint32_t addr, uint8_t *buf, size_t len);
+  bool write(uint32_t addr, const uint8_t *data, size_t len);
+  bool call(bool (*fn)(Adafruit_FRAM_SPI &, void *), void *arg);
+
+private:
+  void push(fram_spi_request_t *req);
+  fram_spi_request_t *pop(void);
+  void execute(fram_spi_request_t *req);
+
+  Adafruit_FRAM_SPI &_fram;
+  std::atomic<fram_spi_request_t *> _tail; // Producers swap themselves in
+  fram_spi_request_t *_head;               // Executor only
+  fram_spi_request_t _stub;                // Keeps the queue non-empty
+};
+
+#endif
+
+#endif
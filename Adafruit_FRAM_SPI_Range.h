@@ -0,0 +1,468 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Range.h
+ *
+ *  Buffered random-access iterators and ranges over a region of an
+ *  Adafruit_FRAM_SPI, so range-for and standard algorithms can walk FRAM.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_RANGE_H_
+#define _ADAFRUIT_FRAM_SPI_RANGE_H_
+
+#include "Adafruit_FRAM_SPI.h"
+#include <stddef.h>
+
+// AVR toolchains ship no C++ standard library
+#if defined(__has_include)
+#if __has_include(<iterator>)
+#include <iterator>
+#define FRAM_SPI_HAS_ITERATOR 1
+#endif
+#if __has_include(<type_traits>)
+#include <type_traits>
+#define FRAM_SPI_HAS_TYPE_TRAITS 1
+#endif
+#endif
+
+#ifndef FRAM_SPI_IS_TRIVIAL
+#ifdef FRAM_SPI_HAS_TYPE_TRAITS
+/// True if T can be moved to and from FRAM as raw bytes
+#define FRAM_SPI_IS_TRIVIAL(T) std::is_trivially_copyable<T>::value
+#else
+/// True if T can be moved to and from FRAM as raw bytes (GCC/Clang builtin)
+#define FRAM_SPI_IS_TRIVIAL(T) __is_trivially_copyable(T)
+#endif
+#endif
+
+template <typename T, uint16_t N> class Adafruit_FRAM_SPI_Range;
+
+/*!
+ *  @brief  Proxy reference to one element of an Adafruit_FRAM_SPI_Range.
+ *          Reading converts to T, assigning stores through the range's
+ *          block buffer.
+ */
+template <typename T, uint16_t N> class Adafruit_FRAM_SPI_Ref {
+public:
+  /*!
+   *  @brief  Refers to one element
+   *  @param  range
+   *          Owning range
+   *  @param  index
+   *          Element index
+   */
+  Adafruit_FRAM_SPI_Ref(Adafruit_FRAM_SPI_Range<T, N> &range, uint32_t index)
+      : _range(range), _index(index) {}
+
+  /*!
+   *  @brief  Reads the element
+   *  @return Element value
+   */
+  operator T() const { return _range.get(_index); }
+
+  /*!
+   *  @brief  Writes the element
+   *  @param  value
+   *          New value
+   *  @return This reference
+   */
+  Adafruit_FRAM_SPI_Ref &operator=(const T &value) {
+    _range.set(_index, value);
+    return *this;
+  }
+
+  /*!
+   *  @brief  Copies another element
+   *  @param  ref
+   *          Element to copy
+   *  @return This reference
+   */
+  Adafruit_FRAM_SPI_Ref &operator=(const Adafruit_FRAM_SPI_Ref &ref) {
+    return *this = (T)ref;
+  }
+
+  /*!
+   *  @brief  Exchanges two elements, for std::swap based algorithms
+   *  @param  a
+   *          First element
+   *  @param  b
+   *          Second element
+   */
+  friend void swap(Adafruit_FRAM_SPI_Ref a, Adafruit_FRAM_SPI_Ref b) {
+    T tmp = a;
+    a = (T)b;
+    b = tmp;
+  }
+
+private:
+  Adafruit_FRAM_SPI_Range<T, N> &_range;
+  uint32_t _index;
+};
+
+/*!
+ *  @brief  Random-access iterator over an Adafruit_FRAM_SPI_Range.
+ *          Dereferencing yields an Adafruit_FRAM_SPI_Ref proxy.
+ */
+template <typename T, uint16_t N> class Adafruit_FRAM_SPI_Iterator {
+public:
+  typedef T value_type;                          ///< Element type
+  typedef ptrdiff_t difference_type;             ///< Distance type
+  typedef void pointer;                          ///< No addressable elements
+  typedef Adafruit_FRAM_SPI_Ref<T, N> reference; ///< Proxy reference
+#ifdef FRAM_SPI_HAS_ITERATOR
+  /// Random access; the proxy reference makes it an input iterator by the
+  /// letter of the standard, which algorithms accept in practice
+  typedef std::random_access_iterator_tag iterator_category;
+#endif
+
+  /*!
+   *  @brief  Points at an element of a range
+   *  @param  range
+   *          Range to iterate
+   *  @param  index
+   *          Element index
+   */
+  Adafruit_FRAM_SPI_Iterator(Adafruit_FRAM_SPI_Range<T, N> *range = NULL,
+                             uint32_t index = 0)
+      : _range(range), _index(index) {}
+
+  /*!
+   *  @brief  Dereferences the iterator
+   *  @return Proxy for the element
+   */
+  reference operator*() const { return reference(*_range, _index); }
+  /*!
+   *  @brief  Accesses an element relative to the iterator
+   *  @param  n
+   *          Offset in elements
+   *  @return Proxy for the element
+   */
+  reference operator[](difference_type n) const {
+    return reference(*_range, _index + n);
+  }
+
+  /*!
+   *  @brief  Pre-increment
+   *  @return This iterator
+   */
+  Adafruit_FRAM_SPI_Iterator &operator++() {
+    _index++;
+    return *this;
+  }
+  /*!
+   *  @brief  Post-increment
+   *  @return Iterator before the increment
+   */
+  Adafruit_FRAM_SPI_Iterator operator++(int) {
+    Adafruit_FRAM_SPI_Iterator it = *this;
+    _index++;
+    return it;
+  }
+  /*!
+   *  @brief  Pre-decrement
+   *  @return This iterator
+   */
+  Adafruit_FRAM_SPI_Iterator &operator--() {
+    _index--;
+    return *this;
+  }
+  /*!
+   *  @brief  Post-decrement
+   *  @return Iterator before the decrement
+   */
+  Adafruit_FRAM_SPI_Iterator operator--(int) {
+    Adafruit_FRAM_SPI_Iterator it = *this;
+    _index--;
+    return it;
+  }
+  /*!
+   *  @brief  Advances the iterator
+   *  @param  n
+   *          Elements to advance
+   *  @return This iterator
+   */
+  Adafruit_FRAM_SPI_Iterator &operator+=(difference_type n) {
+    _index += n;
+    return *this;
+  }
+  /*!
+   *  @brief  Moves the iterator back
+   *  @param  n
+   *          Elements to move back
+   *  @return This iterator
+   */
+  Adafruit_FRAM_SPI_Iterator &operator-=(difference_type n) {
+    _index -= n;
+    return *this;
+  }
+  /*!
+   *  @brief  Offsets an iterator
+   *  @param  n
+   *          Elements to advance
+   *  @return New iterator
+   */
+  Adafruit_FRAM_SPI_Iterator operator+(difference_type n) const {
+    return Adafruit_FRAM_SPI_Iterator(_range, _index + n);
+  }
+  /*!
+   *  @brief  Offsets an iterator backwards
+   *  @param  n
+   *          Elements to move back
+   *  @return New iterator
+   */
+  Adafruit_FRAM_SPI_Iterator operator-(difference_type n) const {
+    return Adafruit_FRAM_SPI_Iterator(_range, _index - n);
+  }
+  /*!
+   *  @brief  Distance between two iterators of the same range
+   *  @param  it
+   *          Other iterator
+   *  @return Elements from it to this
+   */
+  difference_type operator-(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return (difference_type)_index - (difference_type)it._index;
+  }
+
+  /*!
+   *  @brief  Equality
+   *  @param  it
+   *          Other iterator
+   *  @return true if both point at the same element
+   */
+  bool operator==(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return _index == it._index && _range == it._range;
+  }
+  /*!
+   *  @brief  Inequality
+   *  @param  it
+   *          Other iterator
+   *  @return true if the iterators differ
+   */
+  bool operator!=(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return !(*this == it);
+  }
+  /*!
+   *  @brief  Ordering
+   *  @param  it
+   *          Other iterator
+   *  @return true if this comes first
+   */
+  bool operator<(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return _index < it._index;
+  }
+  /*!
+   *  @brief  Ordering
+   *  @param  it
+   *          Other iterator
+   *  @return true if this comes last
+   */
+  bool operator>(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return _index > it._index;
+  }
+  /*!
+   *  @brief  Ordering
+   *  @param  it
+   *          Other iterator
+   *  @return true if this does not come last
+   */
+  bool operator<=(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return _index <= it._index;
+  }
+  /*!
+   *  @brief  Ordering
+   *  @param  it
+   *          Other iterator
+   *  @return true if this does not come first
+   */
+  bool operator>=(const Adafruit_FRAM_SPI_Iterator &it) const {
+    return _index >= it._index;
+  }
+
+private:
+  Adafruit_FRAM_SPI_Range<T, N> *_range;
+  uint32_t _index;
+};
+
+/*!
+ *  @brief  Array-like view of count elements of type T stored at base.
+ *          Accesses go through an internal block of N elements that is
+ *          filled with one burst read and written back with one burst
+ *          write, so sequential walks in either direction cost one
+ *          transaction per block instead of one per element. Blocks are
+ *          aligned to N elements. Stores into a block that was never read
+ *          are gathered without reading it first.
+ *
+ *          T must be trivially copyable. Call flush() (or let the range go
+ *          out of scope) before stored data must be on the device; the
+ *          buffer is private to the range, so do not mix it with other
+ *          writers of the same region.
+ */
+template <typename T, uint16_t N = 16> class Adafruit_FRAM_SPI_Range {
+  static_assert(FRAM_SPI_IS_TRIVIAL(T), "T must be trivially copyable");
+
+public:
+  typedef Adafruit_FRAM_SPI_Iterator<T, N> iterator; ///< Iterator type
+  typedef Adafruit_FRAM_SPI_Ref<T, N> reference;     ///< Proxy reference
+
+  /*!
+   *  @brief  Creates a view over count elements starting at base
+   *  @param  fram
+   *          Device holding the data, already begun
+   *  @param  base
+   *          Address of element 0
+   *  @param  count
+   *          Number of elements
+   */
+  Adafruit_FRAM_SPI_Range(Adafruit_FRAM_SPI &fram, uint32_t base,
+                          uint32_t count)
+      : _fram(fram), _base(base), _count(count), _first(0), _loaded(0),
+        _dirtyLo(0), _dirtyHi(0) {}
+
+  // A copy would hold its own block buffer and write it back twice
+  Adafruit_FRAM_SPI_Range(const Adafruit_FRAM_SPI_Range &) = delete;
+  Adafruit_FRAM_SPI_Range &operator=(const Adafruit_FRAM_SPI_Range &) = delete;
+
+  /*!
+   *  @brief  Writes back pending stores
+   */
+  ~Adafruit_FRAM_SPI_Range() { flush(); }
+
+  /*!
+   *  @brief  Iterator to the first element
+   *  @return Iterator
+   */
+  iterator begin() { return iterator(this, 0); }
+  /*!
+   *  @brief  Iterator past the last element
+   *  @return Iterator
+   */
+  iterator end() { return iterator(this, _count); }
+  /*!
+   *  @brief  Number of elements
+   *  @return Element count
+   */
+  uint32_t size() const { return _count; }
+  /*!
+   *  @brief  Accesses an element
+   *  @param  index
+   *          Element index
+   *  @return Proxy for the element
+   */
+  reference operator[](uint32_t index) { return reference(*this, index); }
+
+  /*!
+   *  @brief  Reads an element through the block buffer
+   *  @param  index
+   *          Element index
+   *  @return Element value, or a zero-filled T if out of range or the
+   *          burst failed
+   */
+  T get(uint32_t index) {
+    T value;
+    memset((void *)&value, 0, sizeof(T));
+    if (index >= _count) {
+      return value;
+    }
+    uint32_t off = index - _first; // Wraps if before the block
+    bool hit = index >= _first && off < N &&
+               (off < _loaded || (off >= _dirtyLo && off < _dirtyHi));
+    if (!hit && !load(index)) {
+      return value;
+    }
+    memcpy((void *)&value, _buf + (uint32_t)(index - _first) * sizeof(T),
+           sizeof(T));
+    return value;
+  }
+
+  /*!
+   *  @brief  Stores an element into the block buffer
+   *  @param  index
+   *          Element index
+   *  @param  value
+   *          New value
+   *  @return false if out of range or writing back the previous block
+   *          failed
+   */
+  bool set(uint32_t index, const T &value) {
+    if (index >= _count) {
+      return false;
+    }
+    bool inBlock = index >= _first && index - _first < N;
+    uint16_t slot = index - _first;
+    // A block that was not read can only grow its dirty span contiguously
+    if (!inBlock ||
+        (slot >= _loaded && _dirtyLo != _dirtyHi &&
+         (slot + 1 < _dirtyLo || slot > _dirtyHi))) {
+      if (!flush()) {
+        return false;
+      }
+      _first = index - index % N;
+      _loaded = 0;
+      slot = index - _first;
+      _dirtyLo = _dirtyHi = slot;
+    }
+    memcpy(_buf + (uint32_t)slot * sizeof(T), (const void *)&value,
+           sizeof(T));
+    if (_dirtyLo == _dirtyHi) {
+      _dirtyLo = slot;
+      _dirtyHi = slot + 1;
+    } else if (slot < _dirtyLo) {
+      _dirtyLo = slot;
+    } else if (slot >= _dirtyHi) {
+      _dirtyHi = slot + 1;
+    }
+    return true;
+  }
+
+  /*!
+   *  @brief  Writes pending stores back in one burst. On failure they stay
+   *          pending, so a later flush() retries them.
+   *  @return true if nothing was pending or the write succeeded
+   */
+  bool flush() {
+    if (_dirtyLo == _dirtyHi) {
+      return true;
+    }
+    uint32_t lo = _dirtyLo, hi = _dirtyHi;
+    if (!_fram.writeEnable(true) ||
+        !_fram.write(_base + (_first + lo) * sizeof(T), _buf + lo * sizeof(T),
+                     (hi - lo) * sizeof(T))) {
+      return false; // Still pending, the next flush() retries
+    }
+    _dirtyLo = _dirtyHi = 0;
+    return true;
+  }
+
+private:
+  /*!
+   *  @brief  Loads the block holding an element
+   *  @param  index
+   *          Element index
+   *  @return true on success
+   */
+  bool load(uint32_t index) {
+    if (!flush()) {
+      return false;
+    }
+    _first = index - index % N;
+    uint32_t n = _count - _first;
+    if (n > N) {
+      n = N;
+    }
+    _loaded = 0;
+    if (!_fram.read(_base + _first * sizeof(T), _buf, n * sizeof(T))) {
+      return false;
+    }
+    _loaded = n;
+    return true;
+  }
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _count;
+  uint32_t _first;             // Element index of _buf[0]
+  uint16_t _loaded;            // Elements read into _buf, 0 if none
+  uint16_t _dirtyLo, _dirtyHi; // Unwritten slots [lo, hi) of _buf
+  uint8_t _buf[N * sizeof(T)];
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Seqlock.cpp
+ *
+ *  Seqlock-protected FRAM records for torn-read-free concurrent access.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Seqlock.h"
+
+/*!
+ *  @brief  Stores a 32-bit value little-endian
+ *  @param  buf
+ *          Destination, 4 bytes
+ *  @param  value
+ *          Value to store
+ */
+static void put32(uint8_t *buf, uint32_t value) {
+  buf[0] = (uint8_t)(value & 0xFF);
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+}
+
+/*!
+ *  @brief  Loads a little-endian 32-bit value
+ *  @param  buf
+ *          Source, 4 bytes
+ *  @return Value
+ */
+static uint32_t get32(const uint8_t *buf) {
+  return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+         ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/*!
+ *  @brief  Describes a record
+ *  @param  fram
+ *          Device holding the record
+ *  @param  addr
+ *          First byte of the record
+ *  @param  size
+ *          Payload size; the record takes size + FRAM_SEQLOCK_OVERHEAD
+ */
+Adafruit_FRAM_SPI_Seqlock::Adafruit_FRAM_SPI_Seqlock(Adafruit_FRAM_SPI &fram,
+                                                     uint32_t addr,
+                                                     uint16_t size)
+    : _fram(fram) {
+  _addr = addr;
+  _size = size;
+  _seq = 0;
+  _collisions = 0;
+}
+
+/*!
+ *  @brief  Picks up the stored sequence number so the writer continues
+ *          above it. Only the writer needs to call this.
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Seqlock::begin(void) {
+  uint8_t front[4], back[4];
+  if (!_fram.read(_addr, front, 4) ||
+      !_fram.read(_addr + 4 + _size, back, 4)) {
+    return false;
+  }
+  uint32_t a = get32(front);
+  uint32_t b = get32(back);
+  _seq = (int32_t)(a - b) > 0 ? a : b;
+  return true;
+}
+
+/*!
+ *  @brief  Stores a new version of the payload
+ *  @param  data
+ *          Payload, the record's size in bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Seqlock::write(const void *data) {
+  // Advance even on failure so a retry never reuses a half-written number
+  uint32_t seq = ++_seq;
+
+  if (_size + FRAM_SEQLOCK_OVERHEAD <= FRAM_SEQLOCK_BURST) {
+    uint8_t buf[FRAM_SEQLOCK_BURST];
+    put32(buf, seq);
+    memcpy(buf + 4, data, _size);
+    put32(buf + 4 + _size, seq);
+    return _fram.writeEnable(true) &&
+           _fram.write(_addr, buf, _size + FRAM_SEQLOCK_OVERHEAD);
+  }
+
+  // Back word first and front word last: a reader going front to back
+  // cannot see both words match around a partly written payload
+  uint8_t word[4];
+  put32(word, seq);
+  return _fram.writeEnable(true) && _fram.write(_addr + 4 + _size, word, 4) &&
+         _fram.writeEnable(true) &&
+         _fram.write(_addr + 4, (const uint8_t *)data, _size) &&
+         _fram.writeEnable(true) && _fram.write(_addr, word, 4);
+}
+
+/*!
+ *  @brief  Reads a consistent version of the payload
+ *  @param  data
+ *          Destination, the record's size in bytes; may hold a partial
+ *          version if false is returned
+ *  @param  retries
+ *          Extra attempts after a mismatch
+ *  @return true if both sequence words matched
+ */
+bool Adafruit_FRAM_SPI_Seqlock::read(void *data, uint8_t retries) {
+  for (uint16_t attempt = 0; attempt <= retries; attempt++) {
+    uint32_t front, back;
+    if (_size + FRAM_SEQLOCK_OVERHEAD <= FRAM_SEQLOCK_BURST) {
+      uint8_t buf[FRAM_SEQLOCK_BURST];
+      if (!_fram.read(_addr, buf, _size + FRAM_SEQLOCK_OVERHEAD)) {
+        return false;
+      }
+      front = get32(buf);
+      back = get32(buf + 4 + _size);
+      if (front == back) {
+        memcpy(data, buf + 4, _size);
+      }
+    } else {
+      uint8_t word[4];
+      if (!_fram.read(_addr, word, 4)) {
+        return false;
+      }
+      front = get32(word);
+      if (!_fram.read(_addr + 4, (uint8_t *)data, _size) ||
+          !_fram.read(_addr + 4 + _size, word, 4)) {
+        return false;
+      }
+      back = get32(word);
+    }
+
+    if (front == back) {
+      _seq = front;
+      return true;
+    }
+    _collisions++;
+  }
+  return false;
+}
+
+/*!
+ *  @brief  Sequence number last written, or last read consistently
+ *  @return Sequence number
+ */
+uint32_t Adafruit_FRAM_SPI_Seqlock::sequence(void) const { return _seq; }
+
+/*!
+ *  @brief  Mismatched reads seen by this instance, retries included
+ *  @return Collision count
+ */
+uint32_t Adafruit_FRAM_SPI_Seqlock::collisions(void) const {
+  return _collisions;
+}
+
+/*!
+ *  @brief  FRAM bytes the record occupies
+ *  @return Payload size plus FRAM_SEQLOCK_OVERHEAD
+ */
+uint32_t Adafruit_FRAM_SPI_Seqlock::footprint(void) const {
+  return (uint32_t)_size + FRAM_SEQLOCK_OVERHEAD;
+}
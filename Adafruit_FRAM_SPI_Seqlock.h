@@ -0,0 +1,88 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Seqlock.h
+ *
+ *  Seqlock-protected FRAM records for torn-read-free concurrent access.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_SEQLOCK_H_
+#define _ADAFRUIT_FRAM_SPI_SEQLOCK_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/// FRAM bytes a record adds around its payload: a sequence word each side
+#define FRAM_SEQLOCK_OVERHEAD 8
+
+#ifndef FRAM_SEQLOCK_BURST
+/// Largest record, overhead included, moved in one burst (stack buffer)
+#define FRAM_SEQLOCK_BURST 64
+#endif
+
+#ifndef FRAM_SEQLOCK_RETRIES
+/// Default number of extra attempts read() makes after a mismatch
+#define FRAM_SEQLOCK_RETRIES 8
+#endif
+
+/*!
+ *  @brief  A fixed-size FRAM record laid out as [seq][payload][seq], all
+ *          words little-endian. The writer stores a new sequence number on
+ *          both sides of the payload; a reader accepts the payload only if
+ *          both words match and otherwise retries, so it never sees a mix
+ *          of two versions. Readers take no lock.
+ *
+ *          Records of up to FRAM_SEQLOCK_BURST bytes are written and read in
+ *          a single transfer. Larger ones are written back word, payload,
+ *          front word and read in the opposite order, which still detects
+ *          any interleaving of the transfers. A write torn by a reset shows
+ *          up as a persistent mismatch until the next write.
+ *
+ *          One writer per record. Readers and the writer use separate
+ *          instances; each bus transfer must itself be atomic, e.g. by
+ *          going through a shared bus lock or Adafruit_FRAM_SPI_Queue.
+ */
+class Adafruit_FRAM_SPI_Seqlock {
+public:
+  Adafruit_FRAM_SPI_Seqlock(Adafruit_FRAM_SPI &fram, uint32_t addr,
+                            uint16_t size);
+
+  bool begin(void);
+  bool write(const void *data);
+  bool read(void *data, uint8_t retries = FRAM_SEQLOCK_RETRIES);
+
+  /*!
+   *  @brief  Writes a value whose size matches the record
+   *  @param  value
+   *          Value to store
+   *  @return true on success
+   */
+  template <typename T> bool put(const T &value) {
+    return sizeof(T) == _size && write(&value);
+  }
+
+  /*!
+   *  @brief  Reads a value whose size matches the record
+   *  @param  value
+   *          Destination
+   *  @param  retries
+   *          Extra attempts after a mismatch
+   *  @return true if a consistent version was read
+   */
+  template <typename T>
+  bool get(T &value, uint8_t retries = FRAM_SEQLOCK_RETRIES) {
+    return sizeof(T) == _size && read(&value, retries);
+  }
+
+  uint32_t sequence(void) const;
+  uint32_t collisions(void) const;
+  uint32_t footprint(void) const;
+
+private:
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _addr;
+  uint16_t _size;
+  uint32_t _seq;
+  uint32_t _collisions;
+};
+
+#endif
@@ -0,0 +1,294 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Snapshot.cpp
+ *
+ *  Copy-on-write snapshots of an FRAM region.
+ *
+ *  Layout of the save area: an 8-byte header {'F', 'S', active, 0,
+ *  blockSize, count}, a table of 16-bit block numbers, one per slot, then
+ *  the slots. A block is copied to its slot and entered in the table before
+ *  count is raised and before the region itself is written.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Snapshot.h"
+
+/*!
+ *  @brief  Creates a snapshot manager
+ *  @param  fram
+ *          Device holding both areas, already begun
+ *  @param  base
+ *          First byte of the protected region
+ *  @param  size
+ *          Region size in bytes
+ *  @param  blockSize
+ *          Copy-on-write granularity in bytes; the region may hold at most
+ *          65535 blocks, or begin() fails
+ *  @param  saveBase
+ *          First byte of the save area, outside the region
+ *  @param  saveSize
+ *          Save area size; it bounds how many blocks may change while a
+ *          snapshot is held
+ *  @param  map
+ *          Block map, FRAM_SNAPSHOT_MAP_BYTES(size, blockSize) bytes, owned
+ *          by the caller
+ */
+Adafruit_FRAM_SPI_Snapshot::Adafruit_FRAM_SPI_Snapshot(
+    Adafruit_FRAM_SPI &fram, uint32_t base, uint32_t size,
+    uint16_t blockSize, uint32_t saveBase, uint32_t saveSize, uint8_t *map)
+    : _fram(fram), _base(base), _size(size), _blockSize(blockSize),
+      _saveBase(saveBase), _map(map) {
+  uint32_t blocks = blockSize ? (size + blockSize - 1) / blockSize : 0;
+  // Block numbers are 16-bit in the save area; refuse larger regions
+  _blocks = blocks > 0xFFFF ? 0 : blocks;
+  uint32_t slots = 0;
+  if (blockSize && saveSize > FRAM_SNAPSHOT_HEADER) {
+    slots = (saveSize - FRAM_SNAPSHOT_HEADER) / (blockSize + 2);
+  }
+  _slots = slots > _blocks ? _blocks : slots;
+  _count = 0;
+  _active = false;
+}
+
+/*!
+ *  @brief  Loads a snapshot left by a previous run and rebuilds the block
+ *          map, or initializes an empty save area
+ *  @return true if the areas are usable
+ */
+bool Adafruit_FRAM_SPI_Snapshot::begin(void) {
+  if (!_blocks || !_slots || !_map) {
+    return false;
+  }
+  memset(_map, 0, (_blocks + 7) / 8);
+
+  uint8_t hdr[FRAM_SNAPSHOT_HEADER];
+  if (!_fram.read(_saveBase, hdr, sizeof(hdr))) {
+    return false;
+  }
+  if (hdr[0] != 'F' || hdr[1] != 'S' ||
+      (hdr[4] | (hdr[5] << 8)) != _blockSize) {
+    return writeHeader(false, 0);
+  }
+  _active = hdr[2];
+  _count = hdr[6] | (hdr[7] << 8);
+  if (_count > _slots) {
+    return writeHeader(false, 0);
+  }
+
+  uint8_t entry[2];
+  for (uint16_t i = 0; i < _count; i++) {
+    if (!_fram.read(_saveBase + FRAM_SNAPSHOT_HEADER + 2 * i, entry, 2)) {
+      return false;
+    }
+    uint16_t block = entry[0] | (entry[1] << 8);
+    if (block < _blocks) {
+      _map[block / 8] |= 1 << (block % 8);
+    }
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Updates the save area header
+ *  @param  active
+ *          true while a snapshot is held
+ *  @param  count
+ *          Slots in use
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Snapshot::writeHeader(bool active, uint16_t count) {
+  uint8_t hdr[FRAM_SNAPSHOT_HEADER] = {
+      'F',
+      'S',
+      active,
+      0,
+      (uint8_t)(_blockSize & 0xFF),
+      (uint8_t)(_blockSize >> 8),
+      (uint8_t)(count & 0xFF),
+      (uint8_t)(count >> 8)};
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_saveBase, hdr, sizeof(hdr))) {
+    return false;
+  }
+  _active = active;
+  _count = count;
+  return true;
+}
+
+/*!
+ *  @brief  FRAM address of a save slot
+ *  @param  slot
+ *          Slot index
+ *  @return Address
+ */
+uint32_t Adafruit_FRAM_SPI_Snapshot::slotAddr(uint16_t slot) const {
+  return _saveBase + FRAM_SNAPSHOT_HEADER + 2UL * _slots +
+         (uint32_t)slot * _blockSize;
+}
+
+/*!
+ *  @brief  Copies bytes within the FRAM through a small stack buffer
+ *  @param  from
+ *          Source address
+ *  @param  to
+ *          Destination address
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Snapshot::copy(uint32_t from, uint32_t to,
+                                      uint16_t len) {
+  uint8_t chunk[32];
+  while (len) {
+    uint16_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+    if (!_fram.read(from, chunk, n) || !_fram.writeEnable(true) ||
+        !_fram.write(to, chunk, n)) {
+      return false;
+    }
+    from += n;
+    to += n;
+    len -= n;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Takes a snapshot of the region as it is now, dropping any
+ *          previous one. Only metadata is written.
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Snapshot::snapshot(void) {
+  if (!writeHeader(true, 0)) {
+    return false;
+  }
+  memset(_map, 0, (_blocks + 7) / 8);
+  return true;
+}
+
+/*!
+ *  @brief  Copies one block to the next free slot before its first write
+ *  @param  block
+ *          Block index
+ *  @return true on success, false if the save area is full
+ */
+bool Adafruit_FRAM_SPI_Snapshot::preserve(uint16_t block) {
+  if (_count >= _slots) {
+    return false;
+  }
+  uint32_t from = _base + (uint32_t)block * _blockSize;
+  uint32_t to = slotAddr(_count);
+  uint16_t len = _blockSize;
+  if (from + len > _base + _size) {
+    len = _base + _size - from;
+  }
+  if (!copy(from, to, len)) {
+    return false;
+  }
+  uint8_t entry[2] = {(uint8_t)(block & 0xFF), (uint8_t)(block >> 8)};
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_saveBase + FRAM_SNAPSHOT_HEADER + 2 * _count, entry, 2) ||
+      !writeHeader(true, _count + 1)) {
+    return false;
+  }
+  _map[block / 8] |= 1 << (block % 8);
+  return true;
+}
+
+/*!
+ *  @brief  Writes to the region, first saving every block it touches for
+ *          the first time since the snapshot
+ *  @param  addr
+ *          Address inside the region
+ *  @param  data
+ *          Data to write
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success; false with the region untouched if the write
+ *          leaves the region or the save area is full
+ */
+bool Adafruit_FRAM_SPI_Snapshot::write(uint32_t addr, const uint8_t *data,
+                                       size_t len) {
+  if (addr < _base || addr - _base > _size || len > _size - (addr - _base)) {
+    return false;
+  }
+  if (!len) {
+    return true;
+  }
+  if (_active) {
+    uint32_t first = (addr - _base) / _blockSize;
+    uint32_t last = (addr - _base + len - 1) / _blockSize;
+    uint32_t needed = 0;
+    for (uint32_t b = first; b <= last; b++) {
+      if (!(_map[b / 8] & (1 << (b % 8)))) {
+        needed++;
+      }
+    }
+    if (needed > (uint32_t)(_slots - _count)) {
+      return false;
+    }
+    for (uint32_t b = first; b <= last; b++) {
+      if (!(_map[b / 8] & (1 << (b % 8))) && !preserve(b)) {
+        return false;
+      }
+    }
+  }
+  return _fram.writeEnable(true) && _fram.write(addr, data, len);
+}
+
+/*!
+ *  @brief  Rolls the region back to the snapshot and ends it
+ *  @return true on success; on failure the snapshot is kept, so restore()
+ *          can be retried
+ */
+bool Adafruit_FRAM_SPI_Snapshot::restore(void) {
+  if (!_active) {
+    return false;
+  }
+  uint8_t entry[2];
+  for (uint16_t i = 0; i < _count; i++) {
+    if (!_fram.read(_saveBase + FRAM_SNAPSHOT_HEADER + 2 * i, entry, 2)) {
+      return false;
+    }
+    uint16_t block = entry[0] | (entry[1] << 8);
+    uint32_t to = _base + (uint32_t)block * _blockSize;
+    uint32_t from = slotAddr(i);
+    uint16_t len = _blockSize;
+    if (to + len > _base + _size) {
+      len = _base + _size - to;
+    }
+    if (!copy(from, to, len)) {
+      return false;
+    }
+  }
+  return discard();
+}
+
+/*!
+ *  @brief  Ends the snapshot, keeping the region as it is
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Snapshot::discard(void) {
+  if (!writeHeader(false, 0)) {
+    return false;
+  }
+  memset(_map, 0, (_blocks + 7) / 8);
+  return true;
+}
+
+/*!
+ *  @brief  Whether a snapshot is held
+ *  @return true between snapshot() and restore() or discard()
+ */
+bool Adafruit_FRAM_SPI_Snapshot::active(void) const { return _active; }
+
+/*!
+ *  @brief  Blocks copied since the snapshot
+ *  @return Slots in use
+ */
+uint16_t Adafruit_FRAM_SPI_Snapshot::saved(void) const { return _count; }
+
+/*!
+ *  @brief  Blocks the save area can hold
+ *  @return Slot count
+ */
+uint16_t Adafruit_FRAM_SPI_Snapshot::capacity(void) const { return _slots; }
@@ -0,0 +1,64 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Snapshot.h
+ *
+ *  Copy-on-write snapshots of an FRAM region.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_SNAPSHOT_H_
+#define _ADAFRUIT_FRAM_SPI_SNAPSHOT_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/// Bytes of block map needed for a region of size bytes
+#define FRAM_SNAPSHOT_MAP_BYTES(size, blockSize)                               \
+  ((((size) + (blockSize) - 1) / (blockSize) + 7) / 8)
+/// Header at the start of the save area
+#define FRAM_SNAPSHOT_HEADER 8
+
+/*!
+ *  @brief  Keeps a restorable snapshot of an FRAM region at the cost of
+ *          the blocks actually changed. snapshot() only resets metadata;
+ *          afterwards the first write() to each block copies that block to
+ *          the save area. restore() copies the saved blocks back and
+ *          discard() forgets them. The save area records which block each
+ *          slot holds, so a snapshot survives a reset and an interrupted
+ *          restore can simply be repeated.
+ *
+ *          Only writes made through write() are tracked.
+ */
+class Adafruit_FRAM_SPI_Snapshot {
+public:
+  Adafruit_FRAM_SPI_Snapshot(Adafruit_FRAM_SPI &fram, uint32_t base,
+                             uint32_t size, uint16_t blockSize,
+                             uint32_t saveBase, uint32_t saveSize,
+                             uint8_t *map);
+
+  bool begin(void);
+  bool snapshot(void);
+  bool restore(void);
+  bool discard(void);
+  bool write(uint32_t addr, const uint8_t *data, size_t len);
+
+  bool active(void) const;
+  uint16_t saved(void) const;
+  uint16_t capacity(void) const;
+
+private:
+  bool preserve(uint16_t block);
+  bool copy(uint32_t from, uint32_t to, uint16_t len);
+  bool writeHeader(bool active, uint16_t count);
+  uint32_t slotAddr(uint16_t slot) const;
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size;
+  uint16_t _blockSize, _blocks;
+  uint32_t _saveBase;
+  uint16_t _slots;
+  uint8_t *_map; // Bit per block already saved
+  uint16_t _count;
+  bool _active;
+};
+
+#endif
@@ -0,0 +1,262 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Stream.cpp
+ *
+ *  Buffered Arduino Stream over a region of an Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Stream.h"
+
+/*!
+ *  @brief  Creates a stream over [base, base + size) positioned at 0
+ *  @param  fram
+ *          Device holding the region, already begun
+ *  @param  base
+ *          First byte of the region
+ *  @param  size
+ *          Region size in bytes
+ *  @param  buffer
+ *          Burst buffer, owned by the caller
+ *  @param  bufSize
+ *          Size of buffer; larger buffers mean fewer, longer transfers
+ */
+Adafruit_FRAM_SPI_Stream::Adafruit_FRAM_SPI_Stream(Adafruit_FRAM_SPI &fram,
+                                                   uint32_t base,
+                                                   uint32_t size,
+                                                   uint8_t *buffer,
+                                                   uint16_t bufSize)
+    : _fram(fram), _base(base), _size(size), _buf(buffer),
+      _bufSize(buffer ? bufSize : 0) {
+  _pos = 0;
+  _bufPos = 0;
+  _bufLen = 0;
+  _dirty = false;
+}
+
+/*!
+ *  @brief  Writes pending data back to the device. On failure the data
+ *          stays pending, so a later sync() retries it.
+ *  @return true if nothing was pending or the burst succeeded
+ */
+bool Adafruit_FRAM_SPI_Stream::sync(void) {
+  if (!_dirty) {
+    return true;
+  }
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + _bufPos, _buf, _bufLen)) {
+    return false;
+  }
+  _dirty = false;
+  return true;
+}
+
+/*!
+ *  @brief  Loads the buffer with data starting at the current position
+ *  @return true if at least one byte is available in the buffer
+ */
+bool Adafruit_FRAM_SPI_Stream::fill(void) {
+  if (!sync()) {
+    return false;
+  }
+  if (_pos >= _size || !_bufSize) {
+    _bufLen = 0;
+    return false;
+  }
+  uint32_t n = _size - _pos;
+  if (n > _bufSize) {
+    n = _bufSize;
+  }
+  _bufPos = _pos;
+  _bufLen = _fram.read(_base + _pos, _buf, n) ? n : 0;
+  return _bufLen != 0;
+}
+
+/*!
+ *  @brief  Writes one byte at the current position
+ *  @param  c
+ *          Byte to write
+ *  @return 1 if written, 0 at the end of the region or on a bus error
+ */
+size_t Adafruit_FRAM_SPI_Stream::write(uint8_t c) { return write(&c, 1); }
+
+/*!
+ *  @brief  Writes bytes at the current position. Data is gathered in the
+ *          buffer; writes larger than the buffer go straight to the device.
+ *  @param  buffer
+ *          Data to write
+ *  @param  size
+ *          Number of bytes
+ *  @return Bytes written, short at the end of the region or on a bus error
+ */
+size_t Adafruit_FRAM_SPI_Stream::write(const uint8_t *buffer, size_t size) {
+  if (_pos >= _size) {
+    setWriteError();
+    return 0;
+  }
+  if (size > _size - _pos) {
+    size = _size - _pos;
+    setWriteError();
+  }
+
+  // Start a fresh write burst unless this extends the pending one
+  if (!_dirty || _pos != _bufPos + _bufLen) {
+    if (!sync()) {
+      setWriteError();
+      return 0;
+    }
+    _bufPos = _pos;
+    _bufLen = 0;
+  }
+
+  if (size > (size_t)(_bufSize - _bufLen)) {
+    // Won't fit: push out what is pending, then send large writes directly
+    if (!sync()) {
+      setWriteError();
+      return 0;
+    }
+    _bufPos = _pos;
+    _bufLen = 0;
+    if (size >= _bufSize) {
+      if (!_fram.writeEnable(true) ||
+          !_fram.write(_base + _pos, buffer, size)) {
+        setWriteError();
+        return 0;
+      }
+      _pos += size;
+      return size;
+    }
+  }
+
+  memcpy(_buf + _bufLen, buffer, size);
+  _bufLen += size;
+  _pos += size;
+  _dirty = true;
+  if (_bufLen == _bufSize && !sync()) {
+    // Hand these bytes back; anything buffered before stays pending
+    setWriteError();
+    _bufLen -= size;
+    _pos -= size;
+    _dirty = _bufLen != 0;
+    return 0;
+  }
+  return size;
+}
+
+/*!
+ *  @brief  Space left until the end of the region
+ *  @return Bytes that can still be written, clamped to 0x7FFF for 16-bit
+ *          int targets
+ */
+int Adafruit_FRAM_SPI_Stream::availableForWrite(void) {
+  uint32_t left = _size - _pos;
+  return left > 0x7FFF ? 0x7FFF : (int)left;
+}
+
+/*!
+ *  @brief  Bytes left until the end of the region
+ *  @return Remaining bytes, clamped to 0x7FFF for 16-bit int targets
+ */
+int Adafruit_FRAM_SPI_Stream::available(void) {
+  return availableForWrite();
+}
+
+/*!
+ *  @brief  Reads one byte and advances
+ *  @return The byte, or -1 at the end of the region
+ */
+int Adafruit_FRAM_SPI_Stream::read(void) {
+  int c = peek();
+  if (c >= 0) {
+    _pos++;
+  }
+  return c;
+}
+
+/*!
+ *  @brief  Returns the next byte without advancing
+ *  @return The byte, or -1 at the end of the region
+ */
+int Adafruit_FRAM_SPI_Stream::peek(void) {
+  if (_dirty || _pos < _bufPos || _pos >= _bufPos + _bufLen) {
+    if (!fill()) {
+      return -1;
+    }
+  }
+  return _buf[_pos - _bufPos];
+}
+
+/*!
+ *  @brief  Reads a block and advances. Data already buffered is used
+ *          first; the rest is fetched in a single burst.
+ *  @param  buffer
+ *          Destination
+ *  @param  size
+ *          Bytes wanted
+ *  @return Bytes read, short at the end of the region or on a bus error
+ */
+size_t Adafruit_FRAM_SPI_Stream::read(uint8_t *buffer, size_t size) {
+  if (!sync()) {
+    return 0;
+  }
+  if (_pos >= _size) {
+    return 0;
+  }
+  if (size > _size - _pos) {
+    size = _size - _pos;
+  }
+
+  size_t done = 0;
+  if (_pos >= _bufPos && _pos < _bufPos + _bufLen) {
+    done = _bufPos + _bufLen - _pos;
+    if (done > size) {
+      done = size;
+    }
+    memcpy(buffer, _buf + (_pos - _bufPos), done);
+    _pos += done;
+  }
+  if (done < size) {
+    if (!_fram.read(_base + _pos, buffer + done, size - done)) {
+      return done;
+    }
+    _pos += size - done;
+    done = size;
+  }
+  return done;
+}
+
+/*!
+ *  @brief  Writes any buffered data to the device
+ */
+void Adafruit_FRAM_SPI_Stream::flush(void) {
+  if (!sync()) {
+    setWriteError();
+  }
+}
+
+/*!
+ *  @brief  Moves the stream position. Pending writes are kept and flushed
+ *          lazily.
+ *  @param  pos
+ *          New position, relative to the start of the region
+ *  @return true if pos is within the region (pos == size is allowed)
+ */
+bool Adafruit_FRAM_SPI_Stream::seek(uint32_t pos) {
+  if (pos > _size) {
+    return false;
+  }
+  _pos = pos;
+  return true;
+}
+
+/*!
+ *  @brief  Current position
+ *  @return Offset from the start of the region
+ */
+uint32_t Adafruit_FRAM_SPI_Stream::tell(void) const { return _pos; }
+
+/*!
+ *  @brief  Region size
+ *  @return Size in bytes
+ */
+uint32_t Adafruit_FRAM_SPI_Stream::size(void) const { return _size; }
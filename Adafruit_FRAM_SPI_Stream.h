@@ -0,0 +1,54 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Stream.h
+ *
+ *  Buffered Arduino Stream over a region of an Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_STREAM_H_
+#define _ADAFRUIT_FRAM_SPI_STREAM_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/*!
+ *  @brief  Stream over a fixed FRAM region, so Print/Stream based code
+ *          (serializers, formatters, CSV writers) can target FRAM. A caller
+ *          supplied buffer coalesces writes into bursts and refills reads in
+ *          bursts. Call flush() before the data must be on the device.
+ */
+class Adafruit_FRAM_SPI_Stream : public Stream {
+public:
+  Adafruit_FRAM_SPI_Stream(Adafruit_FRAM_SPI &fram, uint32_t base,
+                           uint32_t size, uint8_t *buffer, uint16_t bufSize);
+
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  virtual int availableForWrite(void);
+  virtual int available(void);
+  virtual int read(void);
+  virtual int peek(void);
+  virtual void flush(void);
+
+  using Print::write;
+
+  size_t read(uint8_t *buffer, size_t size);
+  bool seek(uint32_t pos);
+  uint32_t tell(void) const;
+  uint32_t size(void) const;
+
+private:
+  bool sync(void);
+  bool fill(void);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size;
+  uint8_t *_buf;
+  uint16_t _bufSize;
+  uint32_t _pos;    // Stream position, relative to _base
+  uint32_t _bufPos; // Region offset of _buf[0]
+  uint16_t _bufLen; // Valid bytes in _buf
+  bool _dirty;      // _buf holds unwritten data
+};
+
+#endif
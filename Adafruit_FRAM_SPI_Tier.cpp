@@ -0,0 +1,481 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Tier.cpp
+ *
+ *  FRAM write buffer in front of slower block storage (SD, NOR flash).
+ *
+ *  Layout of the FRAM region: two 12-byte superblock copies {head, seq,
+ *  check}, the newer valid one naming the oldest live record, then the log.
+ *  Each record is a 12-byte header {seq, addr, len, CRC-16} followed by
+ *  len bytes of data. Records are appended until the log is full; once the
+ *  log drains the next record starts over at offset 0.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Tier.h"
+#include "Adafruit_FRAM_SPI_CRC.h"
+
+/// Mixed into the superblock check word
+#define FRAM_TIER_MAGIC 0x52495446UL // "FTIR"
+
+static void put32(uint8_t *buf, uint32_t value) {
+  buf[0] = (uint8_t)(value & 0xFF);
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *buf) {
+  return buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+/*!
+ *  @brief  Creates a write buffer over an FRAM region
+ *  @param  fram
+ *          Device holding the staging log, already begun
+ *  @param  base
+ *          First byte of the region
+ *  @param  size
+ *          Region size in bytes
+ *  @param  backing
+ *          Store the data ends up in
+ *  @param  buffer
+ *          Optional destage buffer, owned by the caller; adjacent records
+ *          are coalesced into one backing write of up to bufSize bytes
+ *  @param  bufSize
+ *          Size of buffer
+ */
+Adafruit_FRAM_SPI_Tier::Adafruit_FRAM_SPI_Tier(
+    Adafruit_FRAM_SPI &fram, uint32_t base, uint32_t size,
+    Adafruit_FRAM_SPI_Backing &backing, uint8_t *buffer, uint16_t bufSize)
+    : _fram(fram), _backing(backing), _base(base), _buf(buffer),
+      _bufSize(buffer ? bufSize : 0) {
+  _logSize = size > FRAM_TIER_SUPER_SIZE ? size - FRAM_TIER_SUPER_SIZE : 0;
+  _head = _tail = 0;
+  _headSeq = _tailSeq = 1;
+  _pending = 0;
+  _threshold = FRAM_TIER_BATCH;
+  _highWater = _logSize / 2;
+  _slot = 0;
+}
+
+/*!
+ *  @brief  Recovers the log after a reset, or formats an empty one
+ *  @return true if the region is usable
+ */
+bool Adafruit_FRAM_SPI_Tier::begin(void) {
+  if (_logSize <= FRAM_TIER_RECORD_HEADER) {
+    return false;
+  }
+
+  uint8_t sb[FRAM_TIER_SUPER_SIZE];
+  if (!_fram.read(_base, sb, sizeof(sb))) {
+    return false;
+  }
+  bool found = false;
+  for (uint8_t i = 0; i < 2; i++) {
+    uint32_t head = get32(sb + 12 * i);
+    uint32_t seq = get32(sb + 12 * i + 4);
+    if (get32(sb + 12 * i + 8) != (head ^ seq ^ FRAM_TIER_MAGIC) ||
+        head >= _logSize) {
+      continue;
+    }
+    if (!found || (int32_t)(seq - _headSeq) > 0) {
+      _head = head;
+      _headSeq = seq;
+      _slot = i;
+      found = true;
+    }
+  }
+  if (!found) {
+    _head = 0;
+    _headSeq = 1;
+    _slot = 1;
+    if (!writeSuper(0, 1)) {
+      return false;
+    }
+  }
+
+  // Replay: walk records until the sequence or checksum breaks
+  _tail = _head;
+  _tailSeq = _headSeq;
+  _pending = 0;
+  uint32_t seq, addr;
+  uint16_t len;
+  while (readHeader(_tail, &seq, &addr, &len) && seq == _tailSeq &&
+         verify(_tail, seq, addr, len)) {
+    _tail += FRAM_TIER_RECORD_HEADER + len;
+    _tailSeq++;
+    _pending++;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Reads a record header
+ *  @param  off
+ *          Log offset of the record
+ *  @param  seq
+ *          Receives the sequence number
+ *  @param  addr
+ *          Receives the backing address
+ *  @param  len
+ *          Receives the data length
+ *  @return false if no complete record fits at off, or on a bus error
+ */
+bool Adafruit_FRAM_SPI_Tier::readHeader(uint32_t off, uint32_t *seq,
+                                        uint32_t *addr, uint16_t *len) {
+  uint8_t hdr[FRAM_TIER_RECORD_HEADER];
+  if (off + FRAM_TIER_RECORD_HEADER > _logSize ||
+      !_fram.read(_base + FRAM_TIER_SUPER_SIZE + off, hdr, sizeof(hdr))) {
+    return false;
+  }
+  *seq = get32(hdr);
+  *addr = get32(hdr + 4);
+  *len = hdr[8] | (hdr[9] << 8);
+  return *len && *len <= _logSize - off - FRAM_TIER_RECORD_HEADER;
+}
+
+/*!
+ *  @brief  Checks a record's checksum against its header fields and data
+ *  @param  off
+ *          Log offset of the record
+ *  @param  seq
+ *          Sequence number from the header
+ *  @param  addr
+ *          Backing address from the header
+ *  @param  len
+ *          Data length from the header
+ *  @return true if the record is intact
+ */
+bool Adafruit_FRAM_SPI_Tier::verify(uint32_t off, uint32_t seq,
+                                    uint32_t addr, uint16_t len) {
+  uint8_t hdr[FRAM_TIER_RECORD_HEADER];
+  uint32_t at = _base + FRAM_TIER_SUPER_SIZE + off;
+  if (!_fram.read(at, hdr, sizeof(hdr)) || get32(hdr) != seq ||
+      get32(hdr + 4) != addr) {
+    return false;
+  }
+  uint16_t crc = crc16(0xFFFF, hdr, 10);
+  at += FRAM_TIER_RECORD_HEADER;
+  uint8_t chunk[32];
+  while (len) {
+    uint16_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+    if (!_fram.read(at, chunk, n)) {
+      return false;
+    }
+    crc = crc16(crc, chunk, n);
+    at += n;
+    len -= n;
+  }
+  return hdr[10] == (crc & 0xFF) && hdr[11] == (crc >> 8);
+}
+
+/*!
+ *  @brief  Records a new log head in the older superblock copy
+ *  @param  head
+ *          Log offset of the oldest live record
+ *  @param  seq
+ *          Its sequence number
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Tier::writeSuper(uint32_t head, uint32_t seq) {
+  uint8_t sb[12];
+  put32(sb, head);
+  put32(sb + 4, seq);
+  put32(sb + 8, head ^ seq ^ FRAM_TIER_MAGIC);
+  uint8_t slot = _slot ^ 1;
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + 12 * slot, sb, sizeof(sb))) {
+    return false;
+  }
+  _slot = slot;
+  return true;
+}
+
+/*!
+ *  @brief  Stages a write. Returns once the data is durable in FRAM.
+ *          Writes too large to stage are passed through to the backing
+ *          store after everything staged before them. If the log has no
+ *          room left (see available()), the whole log is destaged first, so
+ *          this call then runs at backing store speed.
+ *  @param  addr
+ *          Backing address
+ *  @param  data
+ *          Data to write
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Tier::write(uint32_t addr, const uint8_t *data,
+                                   size_t len) {
+  if (!len) {
+    return true;
+  }
+  if (len > 0xFFFF || FRAM_TIER_RECORD_HEADER + len > _logSize / 2) {
+    return flush() && _backing.write(addr, data, len) && _backing.sync();
+  }
+  if (_tail + FRAM_TIER_RECORD_HEADER + len > _logSize && !flush()) {
+    return false;
+  }
+
+  uint8_t hdr[FRAM_TIER_RECORD_HEADER];
+  put32(hdr, _tailSeq);
+  put32(hdr + 4, addr);
+  hdr[8] = (uint8_t)(len & 0xFF);
+  hdr[9] = (uint8_t)(len >> 8);
+  uint16_t crc = crc16(crc16(0xFFFF, hdr, 10), data, len);
+  hdr[10] = (uint8_t)(crc & 0xFF);
+  hdr[11] = (uint8_t)(crc >> 8);
+
+  uint32_t at = _base + FRAM_TIER_SUPER_SIZE + _tail;
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(at + FRAM_TIER_RECORD_HEADER, data, len) ||
+      !_fram.writeEnable(true) || !_fram.write(at, hdr, sizeof(hdr))) {
+    return false;
+  }
+  _tail += FRAM_TIER_RECORD_HEADER + len;
+  _tailSeq++;
+  _pending++;
+  return true;
+}
+
+/*!
+ *  @brief  Reads through the buffer: the backing store, overlaid with any
+ *          staged data for the range, oldest first
+ *  @param  addr
+ *          Backing address
+ *  @param  buf
+ *          Destination
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Tier::read(uint32_t addr, uint8_t *buf, size_t len) {
+  if (!_backing.read(addr, buf, len)) {
+    return false;
+  }
+  uint32_t off = _head, seq, raddr;
+  uint16_t rlen;
+  for (uint32_t i = 0; i < _pending; i++) {
+    if (!readHeader(off, &seq, &raddr, &rlen)) {
+      return false;
+    }
+    uint32_t lo = raddr > addr ? raddr : addr;
+    uint32_t hi = raddr + rlen < addr + len ? raddr + rlen : addr + len;
+    if (lo < hi &&
+        !_fram.read(_base + FRAM_TIER_SUPER_SIZE + off +
+                        FRAM_TIER_RECORD_HEADER + (lo - raddr),
+                    buf + (lo - addr), hi - lo)) {
+      return false;
+    }
+    off += FRAM_TIER_RECORD_HEADER + rlen;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Background work: destages a batch once enough records are
+ *          staged or the log is past its high-water mark. Call from loop().
+ *  @return false if a destage failed
+ */
+bool Adafruit_FRAM_SPI_Tier::update(void) {
+  if (_pending && (_pending >= _threshold || _tail > _highWater)) {
+    return destage();
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Copies a record's data from FRAM to the backing store
+ *  @param  off
+ *          Log offset of the record
+ *  @param  addr
+ *          Backing address
+ *  @param  len
+ *          Data length
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_Tier::copyOut(uint32_t off, uint32_t addr,
+                                     uint16_t len) {
+  uint8_t chunk[32];
+  uint8_t *buf = _bufSize ? _buf : chunk;
+  uint16_t cap = _bufSize ? _bufSize : sizeof(chunk);
+  uint32_t at = _base + FRAM_TIER_SUPER_SIZE + off + FRAM_TIER_RECORD_HEADER;
+  while (len) {
+    uint16_t n = len < cap ? len : cap;
+    if (!_fram.read(at, buf, n) || !_backing.write(addr, buf, n)) {
+      return false;
+    }
+    at += n;
+    addr += n;
+    len -= n;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Moves the oldest FRAM_TIER_BATCH records to the backing store.
+ *          They are written in backing address order, with runs of
+ *          adjacent records gathered into one write, unless records in the
+ *          batch overlap, in which case log order is kept so the newest
+ *          data wins. The log head advances only after the backing store
+ *          syncs.
+ *  @return true on success, including when nothing was staged
+ */
+bool Adafruit_FRAM_SPI_Tier::destage(void) {
+  if (!_pending) {
+    return true;
+  }
+
+  uint32_t off[FRAM_TIER_BATCH], addr[FRAM_TIER_BATCH];
+  uint16_t len[FRAM_TIER_BATCH];
+  uint8_t order[FRAM_TIER_BATCH];
+  uint8_t n = 0;
+  uint32_t at = _head, seq;
+  while (n < FRAM_TIER_BATCH && n < _pending) {
+    if (!readHeader(at, &seq, &addr[n], &len[n])) {
+      return false;
+    }
+    off[n] = at;
+    order[n] = n;
+    at += FRAM_TIER_RECORD_HEADER + len[n];
+    n++;
+  }
+
+  // Stable insertion sort by backing address
+  for (uint8_t i = 1; i < n; i++) {
+    uint8_t k = order[i];
+    int8_t j = i - 1;
+    for (; j >= 0 && addr[order[j]] > addr[k]; j--) {
+      order[j + 1] = order[j];
+    }
+    order[j + 1] = k;
+  }
+  for (uint8_t i = 1; i < n; i++) {
+    if (addr[order[i]] < addr[order[i - 1]] + len[order[i - 1]]) {
+      for (uint8_t j = 0; j < n; j++) {
+        order[j] = j;
+      }
+      break;
+    }
+  }
+
+  uint16_t runLen = 0;
+  uint32_t runAddr = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t k = order[i];
+    bool joins = runLen && addr[k] == runAddr + runLen &&
+                 runLen + len[k] <= _bufSize;
+    if (runLen && !joins) {
+      if (!_backing.write(runAddr, _buf, runLen)) {
+        return false;
+      }
+      runLen = 0;
+    }
+    if (len[k] > _bufSize) {
+      if (!copyOut(off[k], addr[k], len[k])) {
+        return false;
+      }
+      continue;
+    }
+    if (!runLen) {
+      runAddr = addr[k];
+    }
+    if (!_fram.read(_base + FRAM_TIER_SUPER_SIZE + off[k] +
+                        FRAM_TIER_RECORD_HEADER,
+                    _buf + runLen, len[k])) {
+      return false;
+    }
+    runLen += len[k];
+  }
+  if ((runLen && !_backing.write(runAddr, _buf, runLen)) ||
+      !_backing.sync()) {
+    return false;
+  }
+
+  uint32_t head = at == _tail ? 0 : at;
+  if (!writeSuper(head, _headSeq + n)) {
+    return false;
+  }
+  _head = head;
+  _headSeq += n;
+  _pending -= n;
+  if (!_pending) {
+    _tail = 0;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Destages a bounded amount of work, e.g. while the caller is idle
+ *  @param  batches
+ *          Most batches of FRAM_TIER_BATCH records to destage
+ *  @return false if a destage failed
+ */
+bool Adafruit_FRAM_SPI_Tier::flushSome(uint8_t batches) {
+  while (batches-- && _pending) {
+    if (!destage()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Destages everything
+ *  @return true once the log is empty
+ */
+bool Adafruit_FRAM_SPI_Tier::flush(void) {
+  while (_pending) {
+    if (!destage()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Sets how many staged records make update() destage
+ *  @param  records
+ *          Record count, at least 1
+ */
+void Adafruit_FRAM_SPI_Tier::setDestageThreshold(uint16_t records) {
+  _threshold = records ? records : 1;
+}
+
+/*!
+ *  @brief  Sets the high-water mark: update() destages whenever more log
+ *          space than this is in use, whatever the record count
+ *  @param  bytes
+ *          Log bytes, half the log by default
+ */
+void Adafruit_FRAM_SPI_Tier::setHighWater(uint32_t bytes) {
+  _highWater = bytes < _logSize ? bytes : _logSize;
+}
+
+/*!
+ *  @brief  Records waiting to be destaged
+ *  @return Record count
+ */
+uint32_t Adafruit_FRAM_SPI_Tier::pending(void) const { return _pending; }
+
+/*!
+ *  @brief  Log space in use
+ *  @return Bytes of the log holding staged records
+ */
+uint32_t Adafruit_FRAM_SPI_Tier::used(void) const { return _tail - _head; }
+
+/*!
+ *  @brief  Largest write that can be staged without stalling on a destage
+ *  @return Data bytes, 0 if the next write will drain the log first
+ */
+uint32_t Adafruit_FRAM_SPI_Tier::available(void) const {
+  // Larger writes bypass the log, see write()
+  uint32_t room = _logSize - _tail;
+  if (room > _logSize / 2) {
+    room = _logSize / 2;
+  }
+  return room > FRAM_TIER_RECORD_HEADER ? room - FRAM_TIER_RECORD_HEADER : 0;
+}
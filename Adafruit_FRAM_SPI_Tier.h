@@ -0,0 +1,112 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Tier.h
+ *
+ *  FRAM write buffer in front of slower block storage (SD, NOR flash).
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_TIER_H_
+#define _ADAFRUIT_FRAM_SPI_TIER_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/// Records destaged per batch
+#define FRAM_TIER_BATCH 16
+/// Bytes of FRAM taken by the two superblock copies
+#define FRAM_TIER_SUPER_SIZE 24
+/// Bytes of FRAM taken by each record header
+#define FRAM_TIER_RECORD_HEADER 12
+
+/*!
+ *  @brief  Slow storage behind an Adafruit_FRAM_SPI_Tier. Implement it for
+ *          an SD card, a NOR flash, or a file when testing on a host.
+ */
+class Adafruit_FRAM_SPI_Backing {
+public:
+  /*!
+   *  @brief  Reads from the backing store
+   *  @param  addr
+   *          Byte address
+   *  @param  buf
+   *          Destination
+   *  @param  len
+   *          Number of bytes
+   *  @return true on success
+   */
+  virtual bool read(uint32_t addr, uint8_t *buf, size_t len) = 0;
+  /*!
+   *  @brief  Writes to the backing store
+   *  @param  addr
+   *          Byte address
+   *  @param  buf
+   *          Data to write
+   *  @param  len
+   *          Number of bytes
+   *  @return true on success
+   */
+  virtual bool write(uint32_t addr, const uint8_t *buf, size_t len) = 0;
+  /*!
+   *  @brief  Makes completed writes durable
+   *  @return true on success
+   */
+  virtual bool sync(void) { return true; }
+};
+
+/*!
+ *  @brief  Absorbs small writes to a backing store in an FRAM staging log.
+ *          write() returns once the data is in FRAM; update() destages the
+ *          oldest records in batches sorted by backing address and coalesced
+ *          into long writes. read() sees staged data. The log is replayed at
+ *          begin() after a reset: a record counts only if its sequence
+ *          number and checksum are intact, and the log head only moves after
+ *          the backing store has synced the batch, so a crash at any point
+ *          leaves every acknowledged write either staged or destaged.
+ *
+ *          The log is linear and its space is reclaimed once it has fully
+ *          drained. A write that finds no room stalls while the whole log
+ *          is destaged at backing store speed. Keep update() running, lower
+ *          the high-water mark, or call flushSome() when idle to stay clear
+ *          of that; available() tells whether the next write will stall.
+ */
+class Adafruit_FRAM_SPI_Tier {
+public:
+  Adafruit_FRAM_SPI_Tier(Adafruit_FRAM_SPI &fram, uint32_t base,
+                         uint32_t size, Adafruit_FRAM_SPI_Backing &backing,
+                         uint8_t *buffer = NULL, uint16_t bufSize = 0);
+
+  bool begin(void);
+  bool write(uint32_t addr, const uint8_t *data, size_t len);
+  bool read(uint32_t addr, uint8_t *buf, size_t len);
+  bool update(void);
+  bool destage(void);
+  bool flushSome(uint8_t batches);
+  bool flush(void);
+
+  void setDestageThreshold(uint16_t records);
+  void setHighWater(uint32_t bytes);
+  uint32_t pending(void) const;
+  uint32_t used(void) const;
+  uint32_t available(void) const;
+
+private:
+  bool readHeader(uint32_t off, uint32_t *seq, uint32_t *addr,
+                  uint16_t *len);
+  bool verify(uint32_t off, uint32_t seq, uint32_t addr, uint16_t len);
+  bool writeSuper(uint32_t head, uint32_t seq);
+  bool copyOut(uint32_t off, uint32_t addr, uint16_t len);
+
+  Adafruit_FRAM_SPI &_fram;
+  Adafruit_FRAM_SPI_Backing &_backing;
+  uint32_t _base, _logSize;
+  uint8_t *_buf;
+  uint16_t _bufSize;
+  uint32_t _head, _tail;       // Log offsets of oldest record and free space
+  uint32_t _headSeq, _tailSeq; // Sequence numbers expected at head and tail
+  uint32_t _pending;           // Records between head and tail
+  uint16_t _threshold;         // update() destages at this many records
+  uint32_t _highWater;         // ...or once the tail passes this offset
+  uint8_t _slot;               // Superblock copy written last
+};
+
+#endif
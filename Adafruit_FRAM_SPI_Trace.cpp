@@ -0,0 +1,250 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Trace.cpp
+ *
+ *  Opt-in transaction trace recorder for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Trace.h"
+#include "Adafruit_FRAM_SPI.h"
+
+/// Dump format version written in the header
+#define FRAM_TRACE_VERSION 1
+
+/*!
+ *  @brief  Stores a 32-bit value little-endian
+ *  @param  buf
+ *          Destination, 4 bytes
+ *  @param  value
+ *          Value to store
+ */
+static void put32(uint8_t *buf, uint32_t value) {
+  buf[0] = (uint8_t)(value & 0xFF);
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+}
+
+/*!
+ *  @brief  Creates a trace recorder over caller-owned storage
+ *  @param  entries
+ *          Ring storage, typically a static array
+ *  @param  capacity
+ *          Number of entries in the array
+ */
+Adafruit_FRAM_SPI_Trace::Adafruit_FRAM_SPI_Trace(fram_trace_entry_t *entries,
+                                                 uint16_t capacity) {
+  _entries = entries;
+  _capacity = entries ? capacity : 0;
+  _paused = false;
+  clear();
+}
+
+/*!
+ *  @brief  Appends a transfer, overwriting the oldest one when full
+ *  @param  timestamp
+ *          micros() at the start of the transfer
+ *  @param  op
+ *          Operation class of the calling API
+ *  @param  opcode
+ *          Opcode sent on the bus
+ *  @param  addr
+ *          Array address
+ *  @param  length
+ *          Payload bytes
+ *  @param  ok
+ *          Transfer result
+ */
+void Adafruit_FRAM_SPI_Trace::record(uint32_t timestamp, fram_op_t op,
+                                     uint8_t opcode, uint32_t addr,
+                                     uint32_t length, bool ok) {
+  if (_paused || !_capacity) {
+    return;
+  }
+
+  fram_trace_entry_t &e = _entries[_head];
+  e.timestamp = timestamp;
+  e.addr = addr;
+  e.length = length;
+  e.opcode = opcode;
+  e.op = (uint8_t)op;
+  e.ok = ok ? 1 : 0;
+
+  _head = (_head + 1) % _capacity;
+  if (_count < _capacity) {
+    _count++;
+  } else {
+    _dropped++;
+  }
+}
+
+/*!
+ *  @brief  Discards every entry and the dropped count
+ */
+void Adafruit_FRAM_SPI_Trace::clear(void) {
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+}
+
+/*!
+ *  @brief  Suspends or resumes recording
+ *  @param  paused
+ *          true to ignore transfers until resumed
+ */
+void Adafruit_FRAM_SPI_Trace::pause(bool paused) { _paused = paused; }
+
+/*!
+ *  @brief  Number of entries held
+ *  @return Entry count, at most the capacity
+ */
+uint16_t Adafruit_FRAM_SPI_Trace::count(void) const { return _count; }
+
+/*!
+ *  @brief  Entries lost to ring wrap-around since the last clear()
+ *  @return Dropped entry count
+ */
+uint32_t Adafruit_FRAM_SPI_Trace::dropped(void) const { return _dropped; }
+
+/*!
+ *  @brief  Fetches an entry by age
+ *  @param  index
+ *          0 for the oldest entry held
+ *  @param  entry
+ *          Destination
+ *  @return true if index is in range
+ */
+bool Adafruit_FRAM_SPI_Trace::get(uint16_t index,
+                                  fram_trace_entry_t *entry) const {
+  if (index >= _count || !entry) {
+    return false;
+  }
+  uint16_t first = (_head + _capacity - _count) % _capacity;
+  *entry = _entries[(first + index) % _capacity];
+  return true;
+}
+
+/*!
+ *  @brief  Fills a dump header
+ *  @param  buf
+ *          Destination, FRAM_TRACE_HEADER_SIZE bytes
+ *  @param  count
+ *          Entry count to advertise
+ */
+void Adafruit_FRAM_SPI_Trace::header(uint8_t *buf, uint32_t count) const {
+  buf[0] = 'F';
+  buf[1] = 'T';
+  buf[2] = FRAM_TRACE_VERSION;
+  buf[3] = FRAM_TRACE_ENTRY_SIZE;
+  put32(buf + 4, count);
+  put32(buf + 8, _dropped);
+}
+
+/*!
+ *  @brief  Serializes one entry
+ *  @param  e
+ *          Entry to encode
+ *  @param  buf
+ *          Destination, FRAM_TRACE_ENTRY_SIZE bytes
+ */
+void Adafruit_FRAM_SPI_Trace::serialize(const fram_trace_entry_t &e,
+                                        uint8_t *buf) {
+  put32(buf, e.timestamp);
+  put32(buf + 4, e.addr);
+  put32(buf + 8, e.length);
+  buf[12] = e.opcode;
+  buf[13] = e.op;
+  buf[14] = e.ok;
+  buf[15] = 0;
+}
+
+/*!
+ *  @brief  Streams the binary dump, e.g. to Serial for extras/fram_trace.py
+ *  @param  out
+ *          Destination
+ *  @return Bytes written
+ */
+size_t Adafruit_FRAM_SPI_Trace::writeTo(Print &out) const {
+  uint8_t buf[FRAM_TRACE_ENTRY_SIZE];
+  size_t n;
+
+  header(buf, _count);
+  n = out.write(buf, FRAM_TRACE_HEADER_SIZE);
+
+  fram_trace_entry_t e;
+  for (uint16_t i = 0; get(i, &e); i++) {
+    serialize(e, buf);
+    n += out.write(buf, FRAM_TRACE_ENTRY_SIZE);
+  }
+  return n;
+}
+
+/*!
+ *  @brief  Prints the trace as CSV: timestamp,op,opcode,addr,length,ok
+ *  @param  out
+ *          Destination
+ */
+void Adafruit_FRAM_SPI_Trace::printTo(Print &out) const {
+  fram_trace_entry_t e;
+  for (uint16_t i = 0; get(i, &e); i++) {
+    out.print(e.timestamp);
+    out.print(',');
+    out.print(e.op);
+    out.print(F(",0x"));
+    out.print(e.opcode, HEX);
+    out.print(F(",0x"));
+    out.print(e.addr, HEX);
+    out.print(',');
+    out.print(e.length);
+    out.print(',');
+    out.println(e.ok);
+  }
+}
+
+/*!
+ *  @brief  Copies the trace into a reserved FRAM region so it survives a
+ *          reset. The region receives the same image as writeTo(), keeping
+ *          the newest entries that fit. Recording is paused meanwhile so
+ *          the save does not trace itself.
+ *  @param  fram
+ *          Device holding the region
+ *  @param  addr
+ *          First byte of the region
+ *  @param  size
+ *          Region size in bytes
+ *  @return Entries saved, 0 if the region cannot hold the header
+ */
+uint16_t Adafruit_FRAM_SPI_Trace::saveTo(Adafruit_FRAM_SPI &fram,
+                                         uint32_t addr, uint32_t size) {
+  if (size < FRAM_TRACE_HEADER_SIZE) {
+    return 0;
+  }
+
+  uint32_t fit = (size - FRAM_TRACE_HEADER_SIZE) / FRAM_TRACE_ENTRY_SIZE;
+  uint16_t n = fit < _count ? (uint16_t)fit : _count;
+  uint16_t skip = _count - n;
+  bool was_paused = _paused;
+  _paused = true;
+
+  uint8_t buf[FRAM_TRACE_ENTRY_SIZE];
+  header(buf, n);
+  bool ok = fram.writeEnable(true) &&
+            fram.write(addr, buf, FRAM_TRACE_HEADER_SIZE);
+  addr += FRAM_TRACE_HEADER_SIZE;
+
+  fram_trace_entry_t e;
+  for (uint16_t i = 0; ok && i < n; i++) {
+    if (!get(skip + i, &e)) {
+      ok = false;
+      break;
+    }
+    serialize(e, buf);
+    ok = fram.writeEnable(true) && fram.write(addr, buf, sizeof(buf));
+    addr += FRAM_TRACE_ENTRY_SIZE;
+  }
+  fram.writeEnable(false);
+
+  _paused = was_paused;
+  return ok ? n : 0;
+}
@@ -0,0 +1,75 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_Trace.h
+ *
+ *  Opt-in transaction trace recorder for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_TRACE_H_
+#define _ADAFRUIT_FRAM_SPI_TRACE_H_
+
+#include <Arduino.h>
+
+#include "Adafruit_FRAM_SPI_Histogram.h"
+
+class Adafruit_FRAM_SPI;
+
+/// Size in bytes of the dump header written by writeTo() and saveTo()
+#define FRAM_TRACE_HEADER_SIZE 12
+/// Size in bytes of one serialized entry
+#define FRAM_TRACE_ENTRY_SIZE 16
+
+/*!
+ *  @brief  One recorded bus transfer
+ */
+typedef struct {
+  uint32_t timestamp; ///< micros() when the transfer started
+  uint32_t addr;      ///< Array address, 0 for non-memory opcodes
+  uint32_t length;    ///< Payload bytes moved
+  uint8_t opcode;     ///< Opcode sent, 0 for a wake pulse
+  uint8_t op;         ///< fram_op_t of the calling API
+  uint8_t ok;         ///< 1 if the SPI layer reported success
+} fram_trace_entry_t;
+
+/*!
+ *  @brief  RAM ring buffer of the most recent bus transfers. Storage is
+ *          provided by the caller; once full, the oldest entries are
+ *          overwritten and counted as dropped.
+ *
+ *          Dump format, all fields little-endian: 'F', 'T', version (1),
+ *          entry size (16), uint32 entry count, uint32 dropped count, then
+ *          per entry uint32 timestamp, uint32 addr, uint32 length, uint8
+ *          opcode, uint8 op, uint8 ok, one pad byte. Entries are oldest
+ *          first. extras/fram_trace.py decodes and replays dumps.
+ */
+class Adafruit_FRAM_SPI_Trace {
+public:
+  Adafruit_FRAM_SPI_Trace(fram_trace_entry_t *entries, uint16_t capacity);
+
+  void record(uint32_t timestamp, fram_op_t op, uint8_t opcode, uint32_t addr,
+              uint32_t length, bool ok);
+  void clear(void);
+  void pause(bool paused);
+
+  uint16_t count(void) const;
+  uint32_t dropped(void) const;
+  bool get(uint16_t index, fram_trace_entry_t *entry) const;
+
+  size_t writeTo(Print &out) const;
+  void printTo(Print &out) const;
+  uint16_t saveTo(Adafruit_FRAM_SPI &fram, uint32_t addr, uint32_t size);
+
+private:
+  void header(uint8_t *buf, uint32_t count) const;
+  static void serialize(const fram_trace_entry_t &e, uint8_t *buf);
+
+  fram_trace_entry_t *_entries;
+  uint16_t _capacity;
+  uint16_t _head;
+  uint16_t _count;
+  uint32_t _dropped;
+  bool _paused;
+};
+
+#endif
@@ -0,0 +1,586 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_WAL.cpp
+ *
+ *  Write-ahead log with group commit for Adafruit_FRAM_SPI.
+ *
+ *  Layout of the FRAM region: two 12-byte superblock copies {head, seq,
+ *  check}, the newer valid one naming the oldest group not yet
+ *  checkpointed, then the log. A group is {seq, bytes} followed by bytes of
+ *  updates, each {addr, len} plus data, and closed by the commit marker
+ *  {CRC-16, 'W', 'C'} over everything before it. Each group is written
+ *  in one burst, so a torn group fails its checksum.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_WAL.h"
+#include "Adafruit_FRAM_SPI_CRC.h"
+
+/// Mixed into the superblock check word
+#define FRAM_WAL_MAGIC 0x4C415746UL // "FWAL"
+
+static void put32(uint8_t *buf, uint32_t value) {
+  buf[0] = (uint8_t)(value & 0xFF);
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *buf) {
+  return buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+         ((uint32_t)buf[3] << 24);
+}
+
+/*!
+ *  @brief  Creates a write-ahead log over an FRAM region
+ *  @param  fram
+ *          Device holding the log and the home locations, already begun
+ *  @param  base
+ *          First byte of the log region
+ *  @param  size
+ *          Region size in bytes
+ *  @param  buffer
+ *          Group buffer, owned by the caller; its size bounds both the
+ *          largest transaction and the largest group
+ *  @param  bufSize
+ *          Size of buffer
+ */
+Adafruit_FRAM_SPI_WAL::Adafruit_FRAM_SPI_WAL(Adafruit_FRAM_SPI &fram,
+                                             uint32_t base, uint32_t size,
+                                             uint8_t *buffer,
+                                             uint16_t bufSize)
+    : _fram(fram), _base(base), _size(size), _buf(buffer),
+      _bufSize(buffer ? bufSize : 0) {
+  _logSize = size > FRAM_WAL_SUPER_SIZE ? size - FRAM_WAL_SUPER_SIZE : 0;
+  _groupLen = 0;
+  _groupStart = 0;
+  _window = 1000;
+  _head = _tail = 0;
+  _headSeq = _tailSeq = 1;
+  _slot = 0;
+  _lock = _unlock = NULL;
+  _lockArg = NULL;
+}
+
+/*!
+ *  @brief  Recovers after a reset: redoes every committed group logged
+ *          since the last checkpoint, then empties the log and restarts it
+ *          at the front. A torn last group was never acknowledged and is
+ *          dropped.
+ *  @return true if the log is usable
+ */
+bool Adafruit_FRAM_SPI_WAL::begin(void) {
+  if (_bufSize <= FRAM_WAL_GROUP_OVERHEAD + FRAM_WAL_RECORD_HEADER ||
+      _logSize < _bufSize) {
+    return false;
+  }
+  _groupLen = 0;
+
+  uint8_t sb[FRAM_WAL_SUPER_SIZE];
+  if (!_fram.read(_base, sb, sizeof(sb))) {
+    return false;
+  }
+  bool found = false;
+  for (uint8_t i = 0; i < 2; i++) {
+    uint32_t head = get32(sb + 12 * i);
+    uint32_t seq = get32(sb + 12 * i + 4);
+    if (get32(sb + 12 * i + 8) != (head ^ seq ^ FRAM_WAL_MAGIC) ||
+        head >= _logSize) {
+      continue;
+    }
+    if (!found || (int32_t)(seq - _headSeq) > 0) {
+      _head = head;
+      _headSeq = seq;
+      _slot = i;
+      found = true;
+    }
+  }
+  if (!found) {
+    _head = 0;
+    _headSeq = 1;
+    _slot = 1;
+  }
+
+  _tail = _head;
+  _tailSeq = _headSeq;
+  uint32_t bytes;
+  while (readGroup(_tail, _tailSeq, &bytes)) {
+    _tail += FRAM_WAL_GROUP_OVERHEAD + bytes;
+    _tailSeq++;
+  }
+  return checkpoint() && (found || writeSuper(0, _tailSeq));
+}
+
+/*!
+ *  @brief  Validates the group at a log offset
+ *  @param  off
+ *          Log offset
+ *  @param  seq
+ *          Sequence number the group must carry
+ *  @param  bytes
+ *          Receives the size of its updates
+ *  @return true if a complete, committed group is there
+ */
+bool Adafruit_FRAM_SPI_WAL::readGroup(uint32_t off, uint32_t seq,
+                                      uint32_t *bytes) {
+  uint8_t chunk[32];
+  uint32_t at = _base + FRAM_WAL_SUPER_SIZE + off;
+  if (off + FRAM_WAL_GROUP_OVERHEAD > _logSize || !_fram.read(at, chunk, 8) ||
+      get32(chunk) != seq) {
+    return false;
+  }
+  uint32_t n = get32(chunk + 4);
+  if (n > _logSize - off - FRAM_WAL_GROUP_OVERHEAD) {
+    return false;
+  }
+  uint16_t crc = crc16(0xFFFF, chunk, 8);
+  at += 8;
+  for (uint32_t left = n; left;) {
+    uint16_t k = left < sizeof(chunk) ? left : sizeof(chunk);
+    if (!_fram.read(at, chunk, k)) {
+      return false;
+    }
+    crc = crc16(crc, chunk, k);
+    at += k;
+    left -= k;
+  }
+  if (!_fram.read(at, chunk, 4) || chunk[0] != (crc & 0xFF) ||
+      chunk[1] != (crc >> 8) || chunk[2] != 'W' || chunk[3] != 'C') {
+    return false;
+  }
+  *bytes = n;
+  return true;
+}
+
+/*!
+ *  @brief  Copies the updates of one logged group to their home locations
+ *  @param  off
+ *          Log offset of the group
+ *  @param  bytes
+ *          Size of its updates
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_WAL::applyGroup(uint32_t off, uint32_t bytes) {
+  uint8_t chunk[32];
+  uint32_t at = _base + FRAM_WAL_SUPER_SIZE + off + 8;
+  uint32_t end = at + bytes;
+  while (at < end) {
+    if (!_fram.read(at, chunk, FRAM_WAL_RECORD_HEADER)) {
+      return false;
+    }
+    uint32_t home = get32(chunk);
+    uint16_t len = chunk[4] | (chunk[5] << 8);
+    at += FRAM_WAL_RECORD_HEADER;
+    while (len) {
+      uint16_t k = len < sizeof(chunk) ? len : sizeof(chunk);
+      if (!_fram.read(at, chunk, k) || !_fram.writeEnable(true) ||
+          !_fram.write(home, chunk, k)) {
+        return false;
+      }
+      at += k;
+      home += k;
+      len -= k;
+    }
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Records a new log head in the older superblock copy
+ *  @param  head
+ *          Log offset of the oldest group not checkpointed
+ *  @param  seq
+ *          Its sequence number
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_WAL::writeSuper(uint32_t head, uint32_t seq) {
+  uint8_t sb[12];
+  put32(sb, head);
+  put32(sb + 4, seq);
+  put32(sb + 8, head ^ seq ^ FRAM_WAL_MAGIC);
+  uint8_t slot = _slot ^ 1;
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + 12 * slot, sb, sizeof(sb))) {
+    return false;
+  }
+  _slot = slot;
+  return true;
+}
+
+/*!
+ *  @brief  Adds a transaction to the open group. Its updates commit
+ *          atomically with the group, when the window expires in update(),
+ *          the buffer fills, or sync() is called.
+ *  @param  updates
+ *          Updates making up the transaction; the data is copied
+ *  @param  count
+ *          Number of updates
+ *  @return Ticket for durable(), 0 if the transaction is larger than the
+ *          group buffer, targets the log region, or a full group could not
+ *          be written
+ */
+uint32_t Adafruit_FRAM_SPI_WAL::submit(const fram_wal_update_t *updates,
+                                       uint8_t count) {
+  lock();
+  uint32_t ticket = append(updates, count);
+  unlock();
+  return ticket;
+}
+
+/*!
+ *  @brief  submit() without the lock
+ *  @param  updates
+ *          Updates making up the transaction
+ *  @param  count
+ *          Number of updates
+ *  @return Ticket for durable(), 0 if the transaction was rejected
+ */
+uint32_t Adafruit_FRAM_SPI_WAL::append(const fram_wal_update_t *updates,
+                                       uint8_t count) {
+  uint32_t need = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const fram_wal_update_t &u = updates[i];
+    if (u.addr < _base + _size && u.addr + u.len > _base) {
+      return 0;
+    }
+    need += FRAM_WAL_RECORD_HEADER + u.len;
+  }
+  if (!count || need + FRAM_WAL_GROUP_OVERHEAD > _bufSize) {
+    return 0;
+  }
+  if (_groupLen && _groupLen + need + 4 > _bufSize && !close()) {
+    return 0;
+  }
+  if (!_groupLen) {
+    _groupLen = 8;
+    _groupStart = micros();
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t *rec = _buf + _groupLen;
+    put32(rec, updates[i].addr);
+    rec[4] = (uint8_t)(updates[i].len & 0xFF);
+    rec[5] = (uint8_t)(updates[i].len >> 8);
+    memcpy(rec + FRAM_WAL_RECORD_HEADER, updates[i].data, updates[i].len);
+    _groupLen += FRAM_WAL_RECORD_HEADER + updates[i].len;
+  }
+  return _tailSeq;
+}
+
+/*!
+ *  @brief  Submits a transaction and waits until it is durable. With a
+ *          lock set, the transaction joins the open group and the caller
+ *          yields until the window expires, so commits from other tasks
+ *          arriving meanwhile share one write; whichever waiter sees the
+ *          window expire writes the group for all of them. Without a lock
+ *          nothing else can join, and the group is written at once.
+ *  @param  updates
+ *          Updates making up the transaction
+ *  @param  count
+ *          Number of updates
+ *  @return true once the transaction is committed
+ */
+bool Adafruit_FRAM_SPI_WAL::commit(const fram_wal_update_t *updates,
+                                   uint8_t count) {
+  uint32_t ticket = submit(updates, count);
+  if (!ticket) {
+    return false;
+  }
+  for (;;) {
+    lock();
+    bool done = (int32_t)(_tailSeq - ticket) > 0;
+    bool ok = true;
+    if (!done && (!_lock || (uint32_t)(micros() - _groupStart) >= _window)) {
+      ok = done = close();
+    }
+    unlock();
+    if (done || !ok) {
+      return done;
+    }
+    yield();
+  }
+}
+
+/*!
+ *  @brief  Commits the open group: one WREN+WRITE of every update
+ *          submitted since the last group, followed by its commit marker
+ *  @return true if no group was open or the group is durable
+ */
+bool Adafruit_FRAM_SPI_WAL::sync(void) {
+  lock();
+  bool ok = close();
+  unlock();
+  return ok;
+}
+
+/*!
+ *  @brief  sync() without the lock
+ *  @return true if no group was open or the group is durable
+ */
+bool Adafruit_FRAM_SPI_WAL::close(void) {
+  if (!_groupLen) {
+    return true;
+  }
+  uint32_t len = _groupLen + 4;
+  if (_tail + len > _logSize && !drain()) {
+    return false;
+  }
+  put32(_buf, _tailSeq);
+  put32(_buf + 4, _groupLen - 8);
+  uint16_t crc = crc16(0xFFFF, _buf, _groupLen);
+  _buf[_groupLen] = (uint8_t)(crc & 0xFF);
+  _buf[_groupLen + 1] = (uint8_t)(crc >> 8);
+  _buf[_groupLen + 2] = 'W';
+  _buf[_groupLen + 3] = 'C';
+  if (!_fram.writeEnable(true) ||
+      !_fram.write(_base + FRAM_WAL_SUPER_SIZE + _tail, _buf, len)) {
+    return false;
+  }
+  _tail += len;
+  _tailSeq++;
+  _groupLen = 0;
+  return true;
+}
+
+/*!
+ *  @brief  Checks whether a submitted transaction has committed
+ *  @param  ticket
+ *          Value returned by submit()
+ *  @return true once its group is in the log
+ */
+bool Adafruit_FRAM_SPI_WAL::durable(uint32_t ticket) const {
+  lock();
+  bool done = ticket && (int32_t)(_tailSeq - ticket) > 0;
+  unlock();
+  return done;
+}
+
+/*!
+ *  @brief  Background work, call from loop(): commits the open group once
+ *          its window has expired, otherwise checkpoints one logged group
+ *  @return false on a bus error
+ */
+bool Adafruit_FRAM_SPI_WAL::update(void) {
+  lock();
+  bool ok;
+  if (_groupLen) {
+    ok = (uint32_t)(micros() - _groupStart) < _window || close();
+  } else {
+    ok = checkpointOne();
+  }
+  unlock();
+  return ok;
+}
+
+/*!
+ *  @brief  Moves the oldest logged group to its home locations
+ *  @return true on success, including when the log is empty
+ */
+bool Adafruit_FRAM_SPI_WAL::checkpointOne(void) {
+  if (_head == _tail) {
+    return true;
+  }
+  // Groups between head and tail were validated when written or replayed
+  uint8_t hdr[8];
+  if (!_fram.read(_base + FRAM_WAL_SUPER_SIZE + _head, hdr, sizeof(hdr))) {
+    return false;
+  }
+  uint32_t bytes = get32(hdr + 4);
+  if (!applyGroup(_head, bytes)) {
+    return false;
+  }
+  uint32_t next = _head + FRAM_WAL_GROUP_OVERHEAD + bytes;
+  if (next == _tail) {
+    next = 0;
+  }
+  if (!writeSuper(next, _headSeq + 1)) {
+    return false;
+  }
+  _head = next;
+  _headSeq++;
+  if (!_head) {
+    _tail = 0;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Checkpoints every logged group, leaving the log empty. The open
+ *          group, if any, stays open.
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_WAL::checkpoint(void) {
+  lock();
+  bool ok = drain();
+  unlock();
+  return ok;
+}
+
+/*!
+ *  @brief  checkpoint() without the lock
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_WAL::drain(void) {
+  while (_head != _tail) {
+    if (!checkpointOne()) {
+      return false;
+    }
+  }
+  // Empty, but not at the front when begin() found no valid group where
+  // the superblock points: restart there, or close() overruns the log
+  if (_tail) {
+    if (!writeSuper(0, _tailSeq)) {
+      return false;
+    }
+    _head = _tail = 0;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Applies the updates in a run of records that overlap a range
+ *  @param  addr
+ *          Home address of buf[0]
+ *  @param  buf
+ *          Data to patch
+ *  @param  len
+ *          Number of bytes in buf
+ *  @param  recs
+ *          Records, {addr, len} plus data each
+ *  @param  bytes
+ *          Size of recs
+ */
+void Adafruit_FRAM_SPI_WAL::overlay(uint32_t addr, uint8_t *buf, size_t len,
+                                    const uint8_t *recs, uint32_t bytes) {
+  const uint8_t *end = recs + bytes;
+  while (recs < end) {
+    uint32_t raddr = get32(recs);
+    uint16_t rlen = recs[4] | (recs[5] << 8);
+    const uint8_t *data = recs + FRAM_WAL_RECORD_HEADER;
+    uint32_t lo = raddr > addr ? raddr : addr;
+    uint32_t hi = raddr + rlen < addr + len ? raddr + rlen : addr + len;
+    if (lo < hi) {
+      memcpy(buf + (lo - addr), data + (lo - raddr), hi - lo);
+    }
+    recs = data + rlen;
+  }
+}
+
+/*!
+ *  @brief  Reads home data as the log sees it: home locations patched with
+ *          logged groups not yet checkpointed, then the open group
+ *  @param  addr
+ *          Home address
+ *  @param  buf
+ *          Destination
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_WAL::read(uint32_t addr, uint8_t *buf, size_t len) {
+  lock();
+  bool ok = patch(addr, buf, len);
+  unlock();
+  return ok;
+}
+
+/*!
+ *  @brief  read() without the lock
+ *  @param  addr
+ *          Home address
+ *  @param  buf
+ *          Destination
+ *  @param  len
+ *          Number of bytes
+ *  @return true on success
+ */
+bool Adafruit_FRAM_SPI_WAL::patch(uint32_t addr, uint8_t *buf, size_t len) {
+  if (!_fram.read(addr, buf, len)) {
+    return false;
+  }
+  uint8_t hdr[8];
+  for (uint32_t off = _head; off != _tail;) {
+    uint32_t at = _base + FRAM_WAL_SUPER_SIZE + off;
+    if (!_fram.read(at, hdr, 8)) {
+      return false;
+    }
+    uint32_t end = at + 8 + get32(hdr + 4);
+    for (at += 8; at < end;) {
+      if (!_fram.read(at, hdr, FRAM_WAL_RECORD_HEADER)) {
+        return false;
+      }
+      uint32_t raddr = get32(hdr);
+      uint16_t rlen = hdr[4] | (hdr[5] << 8);
+      at += FRAM_WAL_RECORD_HEADER;
+      uint32_t lo = raddr > addr ? raddr : addr;
+      uint32_t hi = raddr + rlen < addr + len ? raddr + rlen : addr + len;
+      if (lo < hi &&
+          !_fram.read(at + (lo - raddr), buf + (lo - addr), hi - lo)) {
+        return false;
+      }
+      at += rlen;
+    }
+    off = end + 4 - _base - FRAM_WAL_SUPER_SIZE;
+  }
+  if (_groupLen) {
+    overlay(addr, buf, len, _buf + 8, _groupLen - 8);
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Sets how long a group stays open for more transactions. Longer
+ *          windows batch more under load at the cost of commit latency.
+ *  @param  window
+ *          Window in microseconds, 0 to commit on every update() call
+ */
+void Adafruit_FRAM_SPI_WAL::setGroupWindow(uint32_t window) {
+  _window = window;
+}
+
+/*!
+ *  @brief  Makes the log safe to share between tasks. Every call then runs
+ *          under the lock, and commit() waits out the group window so that
+ *          concurrent commits are written together. Call before the other
+ *          tasks start.
+ *  @param  take
+ *          Takes a mutex, NULL to go back to single-task use
+ *  @param  give
+ *          Releases it
+ *  @param  arg
+ *          Passed to both
+ */
+void Adafruit_FRAM_SPI_WAL::setLock(void (*take)(void *),
+                                    void (*give)(void *), void *arg) {
+  _lock = take && give ? take : NULL;
+  _unlock = take && give ? give : NULL;
+  _lockArg = arg;
+}
+
+/*!
+ *  @brief  Takes the lock set by setLock(), if any
+ */
+void Adafruit_FRAM_SPI_WAL::lock(void) const {
+  if (_lock) {
+    _lock(_lockArg);
+  }
+}
+
+/*!
+ *  @brief  Releases the lock set by setLock(), if any
+ */
+void Adafruit_FRAM_SPI_WAL::unlock(void) const {
+  if (_unlock) {
+    _unlock(_lockArg);
+  }
+}
+
+/*!
+ *  @brief  Log space holding groups not yet checkpointed
+ *  @return Bytes in use
+ */
+uint32_t Adafruit_FRAM_SPI_WAL::used(void) const {
+  lock();
+  uint32_t bytes = _tail - _head;
+  unlock();
+  return bytes;
+}
@@ -0,0 +1,110 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_WAL.h
+ *
+ *  Write-ahead log with group commit for Adafruit_FRAM_SPI.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_WAL_H_
+#define _ADAFRUIT_FRAM_SPI_WAL_H_
+
+#include "Adafruit_FRAM_SPI.h"
+
+/// Bytes of FRAM taken by the two superblock copies
+#define FRAM_WAL_SUPER_SIZE 24
+/// Group header {seq, bytes} plus commit marker {check, magic}
+#define FRAM_WAL_GROUP_OVERHEAD 12
+/// Header {addr, len} in front of each update
+#define FRAM_WAL_RECORD_HEADER 6
+
+/*!
+ *  @brief  One update of a transaction: len bytes at a home address
+ */
+typedef struct {
+  uint32_t addr;       ///< Home address in FRAM, outside the log region
+  const uint8_t *data; ///< New contents
+  uint16_t len;        ///< Number of bytes
+} fram_wal_update_t;
+
+/*!
+ *  @brief  Write-ahead log over an FRAM region. Transactions submitted
+ *          within the group window are gathered in a RAM buffer and
+ *          appended together as one WREN+WRITE burst ending in a single
+ *          commit marker, so the per-transaction bus cost falls as the
+ *          batch grows. update() closes the group when the window expires
+ *          and checkpoints committed groups into their home locations in
+ *          the background; read() sees logged data that has not been
+ *          checkpointed yet. begin() redoes only the groups logged since
+ *          the last checkpoint and drops a torn tail.
+ *
+ *          A single task gets group commit by calling submit() and polling
+ *          durable(); commit() there writes its group at once. To share
+ *          the log between tasks, setLock() first: every call is then
+ *          serialized, and a blocking commit() joins the open group and
+ *          yields until one write makes the whole group durable.
+ */
+class Adafruit_FRAM_SPI_WAL {
+public:
+  Adafruit_FRAM_SPI_WAL(Adafruit_FRAM_SPI &fram, uint32_t base, uint32_t size,
+                        uint8_t *buffer, uint16_t bufSize);
+
+  bool begin(void);
+
+  uint32_t submit(const fram_wal_update_t *updates, uint8_t count);
+  /*!
+   *  @brief  Submits a single-update transaction
+   *  @param  addr
+   *          Home address
+   *  @param  data
+   *          New contents
+   *  @param  len
+   *          Number of bytes
+   *  @return Ticket for durable(), 0 if the transaction was rejected
+   */
+  uint32_t submit(uint32_t addr, const uint8_t *data, uint16_t len) {
+    fram_wal_update_t u = {addr, data, len};
+    return submit(&u, 1);
+  }
+  bool commit(const fram_wal_update_t *updates, uint8_t count);
+  bool sync(void);
+  bool durable(uint32_t ticket) const;
+
+  bool update(void);
+  bool checkpoint(void);
+  bool read(uint32_t addr, uint8_t *buf, size_t len);
+
+  void setGroupWindow(uint32_t window);
+  void setLock(void (*take)(void *), void (*give)(void *), void *arg);
+  uint32_t used(void) const;
+
+private:
+  uint32_t append(const fram_wal_update_t *updates, uint8_t count);
+  bool close(void);
+  bool drain(void);
+  bool patch(uint32_t addr, uint8_t *buf, size_t len);
+  void lock(void) const;
+  void unlock(void) const;
+  bool readGroup(uint32_t off, uint32_t seq, uint32_t *bytes);
+  bool applyGroup(uint32_t off, uint32_t bytes);
+  bool checkpointOne(void);
+  bool writeSuper(uint32_t head, uint32_t seq);
+  void overlay(uint32_t addr, uint8_t *buf, size_t len, const uint8_t *recs,
+               uint32_t bytes);
+
+  Adafruit_FRAM_SPI &_fram;
+  uint32_t _base, _size, _logSize;
+  uint8_t *_buf;
+  uint16_t _bufSize;
+  uint16_t _groupLen;          // Bytes used in _buf, 0 with no open group
+  uint32_t _groupStart;        // micros() of the first submit in the group
+  uint32_t _window;            // Group commit window in microseconds
+  uint32_t _head, _tail;       // Log offsets of oldest group and free space
+  uint32_t _headSeq, _tailSeq; // Sequence numbers at head and tail
+  uint8_t _slot;               // Superblock copy written last
+  void (*_lock)(void *);       // Optional mutex, see setLock()
+  void (*_unlock)(void *);
+  void *_lockArg;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "Adafruit_FRAM_SPI.h"
+#include "Adafruit_FRAM_SPI_Deferred.h"
+#include <SPI.h>
+
+/* Example code for logging from an interrupt handler. The ISR only copies
+ * each event into a RAM ring; loop() writes the ring out to FRAM, merging
+ * consecutive log slots into one transfer. */
+
+uint8_t FRAM_CS = 10;
+uint8_t BUTTON_PIN = 2;
+Adafruit_FRAM_SPI fram = Adafruit_FRAM_SPI(FRAM_CS); // use hardware SPI
+
+fram_deferred_entry_t ring[32];
+Adafruit_FRAM_SPI_Deferred deferred(fram, ring, 32);
+
+const uint32_t LOG_BASE = 0x100;
+const uint16_t LOG_SLOTS = 256;
+volatile uint16_t slot = 0;
+
+void onButton(void) {
+  uint32_t now = micros();
+  if (deferred.put(LOG_BASE + slot * sizeof(now), now)) {
+    slot = (slot + 1) % LOG_SLOTS;
+  }
+}
+
+void setup(void) {
+  Serial.begin(9600);
+  while (!Serial)
+    delay(10); // will pause Zero, Leonardo, etc until serial console opens
+
+  if (fram.begin()) {
+    Serial.println("Found SPI FRAM");
+  } else {
+    Serial.println("No SPI FRAM found ... check your connections\r\n");
+    while (1)
+      ;
+  }
+
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButton, FALLING);
+}
+
+void loop(void) {
+  if (deferred.drain()) {
+    fram_deferred_stats_t stats;
+    deferred.stats(&stats);
+    Serial.print("Logged ");
+    Serial.print(stats.drained);
+    Serial.print(" events in ");
+    Serial.print(stats.batches);
+    Serial.print(" writes, ");
+    Serial.print(stats.overflows);
+    Serial.println(" dropped");
+  }
+  delay(100);
+}
@@ -0,0 +1,58 @@
+#include "Adafruit_FRAM_SPI.h"
+#include "Adafruit_FRAM_SPI_Layout.h"
+#include <SPI.h>
+
+/* Example code for describing FRAM contents at compile time. The offsets
+ * below are computed by the compiler; moving or resizing a field that would
+ * overlap another, or outgrow the part, fails the build instead of
+ * corrupting data at runtime. */
+
+uint8_t FRAM_CS = 10;
+Adafruit_FRAM_SPI fram = Adafruit_FRAM_SPI(FRAM_CS); // use hardware SPI
+
+struct Config {
+  uint16_t version;
+  uint8_t channel;
+  uint8_t flags;
+};
+
+struct Sample {
+  uint32_t time;
+  int16_t value;
+};
+
+typedef Adafruit_FRAM_SPI_Field<Config, 0> ConfigField;
+typedef Adafruit_FRAM_SPI_After<ConfigField, uint32_t> BootCount;
+typedef Adafruit_FRAM_SPI_After<BootCount, Sample, 64, 16> Samples;
+FRAM_LAYOUT_ASSERT(FRAM_CAPACITY_MB85RS64V, ConfigField, BootCount, Samples);
+
+void setup(void) {
+  Serial.begin(9600);
+  while (!Serial)
+    delay(10); // will pause Zero, Leonardo, etc until serial console opens
+
+  if (fram.begin()) {
+    Serial.println("Found SPI FRAM");
+  } else {
+    Serial.println("No SPI FRAM found ... check your connections\r\n");
+    while (1)
+      ;
+  }
+
+  uint32_t boots = 0;
+  BootCount::get(fram, &boots);
+  boots++;
+  BootCount::set(fram, boots);
+  Serial.print("Boot count: ");
+  Serial.println(boots);
+
+  Sample s = {millis(), (int16_t)analogRead(A0)};
+  Samples::write(fram, s, boots % Samples::count);
+
+  Serial.print("Samples live at 0x");
+  Serial.print(Samples::offset, HEX);
+  Serial.print(" to 0x");
+  Serial.println(Samples::end, HEX);
+}
+
+void loop(void) {}
@@ -0,0 +1,132 @@
+#include "Adafruit_FRAM_SPI.h"
+#include "Adafruit_FRAM_SPI_LittleFS.h"
+#include <SPI.h>
+
+/* Benchmark of a LittleFS file system on the Adafruit SPI FRAM breakout:
+ * file create, append and read throughput. Needs a core or library that
+ * provides lfs.h (e.g. the Adafruit nRF52 core).
+ *
+ * NOTE: This sketch will format the FRAM and erase everything on it */
+
+uint8_t FRAM_CS = 10;
+Adafruit_FRAM_SPI fram = Adafruit_FRAM_SPI(FRAM_CS); // use hardware SPI
+
+#ifdef FRAM_SPI_HAS_LITTLEFS
+
+Adafruit_FRAM_SPI_LittleFS framfs = Adafruit_FRAM_SPI_LittleFS(fram);
+lfs_t lfs;
+
+void report(const char *what, uint32_t bytes, uint32_t us) {
+  Serial.print(what);
+  Serial.print(": ");
+  Serial.print(bytes);
+  Serial.print(" bytes in ");
+  Serial.print(us);
+  Serial.print(" us = ");
+  Serial.print(us ? (bytes * 1000UL) / us : 0);
+  Serial.println(" KB/s");
+}
+
+// Prints a LittleFS error code, returning true if err is one
+bool failed(const char *what, int err) {
+  if (err >= 0)
+    return false;
+  Serial.print(what);
+  Serial.print(" failed: ");
+  Serial.println(err);
+  return true;
+}
+
+// Runs the timings on the mounted file system, stopping at the first error
+void bench(void) {
+  static uint8_t chunk[64];
+  for (uint16_t i = 0; i < sizeof(chunk); i++)
+    chunk[i] = i;
+  const uint32_t total = fram.getSize() / 4;
+  lfs_file_t file;
+  uint32_t start;
+  int err;
+
+  // Create: many small files
+  start = micros();
+  char name[8];
+  for (uint8_t i = 0; i < 16; i++) {
+    snprintf(name, sizeof(name), "f%u", i);
+    err = lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT);
+    if (failed("open", err))
+      return;
+    lfs_ssize_t n = lfs_file_write(&lfs, &file, chunk, sizeof(chunk));
+    err = lfs_file_close(&lfs, &file);
+    if (failed("write", n) || failed("close", err))
+      return;
+  }
+  report("create 16 files", 16 * sizeof(chunk), micros() - start);
+
+  // Append: one log file grown in small records
+  start = micros();
+  err = lfs_file_open(&lfs, &file, "log", LFS_O_WRONLY | LFS_O_CREAT);
+  if (failed("open", err))
+    return;
+  uint32_t wrote = 0;
+  lfs_ssize_t n = 0;
+  while (wrote < total) {
+    n = lfs_file_write(&lfs, &file, chunk, sizeof(chunk));
+    if (n <= 0)
+      break;
+    wrote += n;
+  }
+  err = lfs_file_close(&lfs, &file);
+  if (failed("append", n) || failed("close", err))
+    return;
+  report("append", wrote, micros() - start);
+
+  // Read it back
+  start = micros();
+  err = lfs_file_open(&lfs, &file, "log", LFS_O_RDONLY);
+  if (failed("open", err))
+    return;
+  uint32_t got = 0;
+  while ((n = lfs_file_read(&lfs, &file, chunk, sizeof(chunk))) > 0)
+    got += n;
+  lfs_file_close(&lfs, &file);
+  if (failed("read", n))
+    return;
+  report("read", got, micros() - start);
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10); // will pause Zero, Leonardo, etc until serial console opens
+
+  if (!fram.begin() || !framfs.begin()) {
+    Serial.println("No SPI FRAM found ... check your connections\r\n");
+    while (1)
+      ;
+  }
+  Serial.print("FRAM size: ");
+  Serial.println(fram.getSize());
+
+  lfs_format(&lfs, framfs.config());
+  if (lfs_mount(&lfs, framfs.config()) != 0) {
+    Serial.println("Mount failed\r\n");
+    while (1)
+      ;
+  }
+
+  bench();
+  lfs_unmount(&lfs);
+}
+
+#else
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+  Serial.println("lfs.h is not available on this platform");
+}
+
+#endif
+
+void loop(void) {}
@@ -0,0 +1,74 @@
+#include "Adafruit_FRAM_SPI.h"
+#include <SPI.h>
+
+/* Example code for the low-power modes of the Adafruit SPI FRAM breakout.
+ * Only parts with sleep support (e.g. MB85RS64T, MB85RS4MTY) can be used */
+
+uint8_t FRAM_CS = 10;
+Adafruit_FRAM_SPI fram = Adafruit_FRAM_SPI(FRAM_CS); // use hardware SPI
+
+const char *modeNames[] = {"sleep", "deep power-down", "hibernate"};
+
+void setup(void) {
+  Serial.begin(9600);
+  while (!Serial)
+    delay(10); // will pause Zero, Leonardo, etc until serial console opens
+
+  if (fram.begin()) {
+    Serial.println("Found SPI FRAM");
+  } else {
+    Serial.println("No SPI FRAM found ... check your connections\r\n");
+    while (1)
+      ;
+  }
+
+  for (uint8_t m = 0; m < FRAM_LP_MODES; m++) {
+    fram_lowpower_t mode = (fram_lowpower_t)m;
+    if (!fram.hasLowPower(mode))
+      continue;
+    Serial.print(modeNames[m]);
+    Serial.print(": wake ");
+    Serial.print(fram.getLowPowerWakeMicros(mode));
+    Serial.print(" us, ");
+    Serial.print(fram.getLowPowerNanoamps(mode));
+    Serial.println(" nA");
+  }
+
+  // Sleep after 100 ms of inactivity, in the deepest mode that can be left
+  // within 500 us
+  if (!fram.setAutoSleep(100, 500)) {
+    Serial.println("This FRAM has no low-power mode\r\n");
+    while (1)
+      ;
+  }
+}
+
+void loop(void) {
+  fram.update();
+
+  static uint32_t last = 0;
+  if (millis() - last < 2000)
+    return;
+  last = millis();
+
+  // Start waking the part now and do other work during tREC...
+  fram.startWake();
+  uint32_t spins = 0;
+  while (!fram.isAwake())
+    spins++;
+
+  // ...the read only waits for whatever is left of tREC (nothing here)
+  uint8_t value = fram.read8(0x0);
+
+  fram_spi_power_stats_t stats;
+  fram.getPowerStats(&stats);
+  Serial.print("Byte 0 = 0x");
+  Serial.print(value, HEX);
+  Serial.print(", idle spins during wake: ");
+  Serial.print(spins);
+  Serial.print(", sleeps: ");
+  Serial.print(stats.sleeps);
+  Serial.print(", asleep for ");
+  Serial.print(stats.sleepMillis);
+  Serial.println(" ms");
+}
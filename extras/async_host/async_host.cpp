@@ -0,0 +1,158 @@
+/*!
+ *  @file async_host.cpp
+ *
+ *  Host test for Adafruit_FRAM_SPI_Async: spawned tasks that await nested
+ *  tasks and bus operations, run once with the executor owning the bus
+ *  and once with a separate I/O thread (ownsIO = false) and a wakeup
+ *  callback. Build and run from the library root on Linux:
+ *
+ *      g++ -std=c++20 -O2 -pthread -Iextras/host -I. \
+ *          extras/async_host/async_host.cpp extras/host/host.cpp \
+ *          Adafruit_FRAM_SPI.cpp Adafruit_FRAM_SPI_Queue.cpp \
+ *          Adafruit_FRAM_SPI_Async.cpp Adafruit_FRAM_SPI_Changes.cpp \
+ *          Adafruit_FRAM_SPI_Heatmap.cpp Adafruit_FRAM_SPI_Histogram.cpp \
+ *          Adafruit_FRAM_SPI_Trace.cpp -o async_host && ./async_host
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Async.h"
+
+#ifndef FRAM_SPI_HAS_COROUTINE
+#error "build with -std=c++20 on a compiler with <coroutine>"
+#endif
+
+#include <thread>
+
+#define LOG_BASE 16 // First record of the log; its count is at address 0
+
+static Adafruit_FRAM_SPI fram(0);
+static Adafruit_FRAM_SPI_Queue queue(fram);
+static int failures;
+static int finished;
+
+static void check(bool ok, const char *what) {
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+// Innermost task: reads the record count
+static Adafruit_FRAM_SPI_Task<uint16_t> count(Adafruit_FRAM_SPI_Async &io) {
+  uint8_t buf[2];
+  bool ok = co_await io.read(0, buf, sizeof(buf));
+  co_return ok ? buf[0] | (buf[1] << 8) : 0xFFFF;
+}
+
+// Middle task: appends one record, then bumps the count
+static Adafruit_FRAM_SPI_Task<bool> append(Adafruit_FRAM_SPI_Async &io,
+                                           uint8_t value) {
+  uint16_t n = co_await count(io);
+  if (n == 0xFFFF) {
+    co_return false;
+  }
+  uint8_t rec[4] = {value, value, value, value};
+  bool ok = co_await io.write(LOG_BASE + 4 * n, rec, sizeof(rec));
+  if (!ok) {
+    co_return false;
+  }
+  n++;
+  uint8_t buf[2] = {(uint8_t)(n & 0xFF), (uint8_t)(n >> 8)};
+  co_return co_await io.write(0, buf, sizeof(buf));
+}
+
+// Spawned task: a run of appends and a status register round trip
+static Adafruit_FRAM_SPI_Task<> job(Adafruit_FRAM_SPI_Async &io,
+                                    uint8_t records) {
+  for (uint8_t i = 0; i < records; i++) {
+    bool ok = co_await append(io, i);
+    if (!ok) {
+      failures++;
+    }
+  }
+  uint8_t sr = 0;
+  bool ok = co_await io.setStatus(0x0C);
+  ok = ok && co_await io.status(&sr);
+  check(ok && (sr & 0x0C) == 0x0C, "status register round trip");
+  ok = co_await io.setStatus(0);
+  finished++;
+}
+
+static uint16_t stored(void) {
+  uint8_t buf[2];
+  fram.read(0, buf, sizeof(buf));
+  return buf[0] | (buf[1] << 8);
+}
+
+static void reset(void) {
+  uint8_t zero[2] = {0, 0};
+  fram.writeEnable(true);
+  fram.write(0, zero, sizeof(zero));
+  finished = 0;
+}
+
+int main(void) {
+  if (!fram.begin()) {
+    printf("FAIL: no FRAM\n");
+    return 1;
+  }
+
+  // The executor runs the queue itself, as on an MCU
+  reset();
+  {
+    Adafruit_FRAM_SPI_Async io(queue);
+    io.spawn(job(io, 10));
+    check(!io.idle(), "spawned task is pending");
+    io.run();
+    check(io.idle() && finished == 1, "run() finishes the task");
+  }
+  check(stored() == 10, "nested tasks appended every record");
+
+  // Two tasks interleaved, polled by hand
+  reset();
+  {
+    Adafruit_FRAM_SPI_Async io(queue);
+    io.spawn(job(io, 5));
+    io.spawn(job(io, 5));
+    uint32_t polls = 0;
+    while (!io.idle() && polls < 100000) {
+      io.poll();
+      polls++;
+    }
+    check(finished == 2, "poll() drives two tasks to completion");
+  }
+  // Both read the same count before writing, so the total is not 10;
+  // only the interleaving is under test here
+  check(stored() >= 5 && stored() <= 10, "interleaved appends landed");
+
+  // A dedicated I/O thread owns the bus; completions wake the executor
+  reset();
+  std::atomic<bool> stop(false);
+  std::atomic<int> wakes(0);
+  std::thread io_thread([&] {
+    while (!stop.load()) {
+      if (!queue.poll()) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  {
+    Adafruit_FRAM_SPI_Async io(queue, false);
+    io.setWakeup([](void *arg) { ++*(std::atomic<int> *)arg; }, &wakes);
+    io.spawn(job(io, 50));
+    io.run();
+    check(io.idle() && finished == 1, "ownsIO = false finishes the task");
+  }
+  stop = true;
+  io_thread.join();
+  check(stored() == 50, "I/O thread appended every record");
+  check(wakes.load() > 0, "wakeup callback ran");
+
+  uint8_t last[4];
+  fram.read(LOG_BASE + 4 * 49, last, sizeof(last));
+  check(last[0] == 49 && last[3] == 49, "last record intact");
+
+  printf("%s\n", failures ? "FAIL" : "PASS");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+/*!
+ *  @file changes_mirror.cpp
+ *
+ *  Host test for Adafruit_FRAM_SPI_Changes: replicates one simulated FRAM
+ *  into another through writeDelta()/applyDelta(), first as a full image
+ *  and then incrementally, and checks that corrupted, forged or
+ *  misdirected deltas leave the mirror's bytes alone. Build and run from
+ *  the library root on Linux:
+ *
+ *      g++ -std=c++11 -O2 -Iextras/host -I. \
+ *          extras/changes_mirror/changes_mirror.cpp extras/host/host.cpp \
+ *          Adafruit_FRAM_SPI.cpp Adafruit_FRAM_SPI_Changes.cpp \
+ *          Adafruit_FRAM_SPI_Heatmap.cpp Adafruit_FRAM_SPI_Histogram.cpp \
+ *          Adafruit_FRAM_SPI_Trace.cpp -o changes_mirror && ./changes_mirror
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI.h"
+#include "Adafruit_FRAM_SPI_CRC.h"
+#include <vector>
+
+// Delta held in RAM, written as a Print and read back as a Stream
+class DeltaBuffer : public Stream {
+public:
+  std::vector<uint8_t> bytes; ///< Delta as written
+  size_t pos;                 ///< Next byte to read
+
+  DeltaBuffer() : pos(0) {}
+  using Stream::write;
+  size_t write(uint8_t c) {
+    bytes.push_back(c);
+    return 1;
+  }
+  int available(void) { return (int)(bytes.size() - pos); }
+  int read(void) { return pos < bytes.size() ? bytes[pos++] : -1; }
+  int peek(void) { return pos < bytes.size() ? bytes[pos] : -1; }
+};
+
+static Adafruit_FRAM_SPI source(0);
+static Adafruit_FRAM_SPI mirror(1);
+static uint32_t seqs[FRAM_CHANGES_BLOCKS(8192, 8)];
+static Adafruit_FRAM_SPI_Changes changes(seqs, sizeof(seqs) / 4);
+static int failures;
+
+static void check(bool ok, const char *what) {
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+static bool same(void) {
+  return !memcmp(hostFram[0].mem, hostFram[1].mem, sizeof(hostFram[0].mem));
+}
+
+static void put(uint32_t addr, const char *text) {
+  source.writeEnable(true);
+  source.write(addr, (const uint8_t *)text, strlen(text));
+}
+
+// Applies a delta to the mirror, optionally with one byte flipped, and
+// reports whether the mirror's contents moved
+// Appends a run header {addr, len, CRC-16} as writeDelta() would
+static void runHeader(DeltaBuffer &delta, uint32_t addr, uint16_t len) {
+  uint8_t hdr[8];
+  for (uint8_t i = 0; i < 4; i++) {
+    hdr[i] = (uint8_t)(addr >> (8 * i));
+  }
+  hdr[4] = (uint8_t)(len & 0xFF);
+  hdr[5] = (uint8_t)(len >> 8);
+  uint16_t crc = crc16(0xFFFF, hdr, 6);
+  hdr[6] = (uint8_t)(crc & 0xFF);
+  hdr[7] = (uint8_t)(crc >> 8);
+  delta.write(hdr, sizeof(hdr));
+}
+
+static uint32_t apply(DeltaBuffer &delta, uint32_t at, long flip,
+                      bool *untouched) {
+  static uint8_t before[sizeof(hostFram[1].mem)];
+  memcpy(before, hostFram[1].mem, sizeof(before));
+  DeltaBuffer in;
+  in.bytes = delta.bytes;
+  if (flip >= 0) {
+    in.bytes[flip] ^= 0x10;
+  }
+  uint32_t to = Adafruit_FRAM_SPI_Changes::applyDelta(mirror, in, at);
+  *untouched = !memcmp(before, hostFram[1].mem, sizeof(before));
+  return to;
+}
+
+int main(void) {
+  if (!source.begin() || !mirror.begin()) {
+    printf("FAIL: no FRAM\n");
+    return 1;
+  }
+  source.setChanges(&changes);
+  check(changes.begin(source.getSize()), "tracker begins");
+  for (uint32_t i = 0; i < sizeof(hostFram[0].mem); i++) {
+    hostFram[0].mem[i] = (uint8_t)(i * 7);
+  }
+
+  // Full sync of a blank mirror
+  DeltaBuffer full;
+  check(changes.writeDelta(source, 0, full) > 8192, "full delta written");
+  bool untouched;
+  uint32_t at = apply(full, 0, -1, &untouched);
+  check(at == changes.sequence() && same(), "full sync matches");
+
+  // Incremental sync of two separate extents
+  put(100, "first change");
+  put(5000, "second change, across a block boundary at 5120.......");
+  DeltaBuffer inc;
+  changes.writeDelta(source, at, inc);
+  check(inc.bytes.size() < full.bytes.size() / 4, "incremental is small");
+  DeltaBuffer stale;
+  stale.bytes = inc.bytes;
+  at = apply(inc, at, -1, &untouched);
+  check(at == changes.sequence() && same(), "incremental sync matches");
+
+  // One more change, carried in a single run
+  uint32_t old = at;
+  put(300, "third change");
+  DeltaBuffer one;
+  changes.writeDelta(source, old, one);
+  // Offsets: 12-byte stream header, then the run's {addr, len, CRC}
+  const long header = 2, addr = 12 + 1, len = 12 + 4, hcrc = 12 + 6;
+  const long data = 12 + 8 + 20, dcrc = one.bytes.size() - 8 - 2;
+  const long close = one.bytes.size() - 8;
+  const long flips[] = {header, addr, len, hcrc, data, dcrc, close};
+  const char *names[] = {"stream header", "run address", "run length",
+                         "run header CRC", "run data", "run data CRC",
+                         "closing run"};
+  for (int i = 0; i < 7; i++) {
+    char what[64];
+    uint32_t to = apply(one, old, flips[i], &untouched);
+    snprintf(what, sizeof(what), "corrupt %s rejected", names[i]);
+    check(!to, what);
+    // The closing run is checked after the data run was written
+    if (flips[i] != close) {
+      snprintf(what, sizeof(what), "corrupt %s leaves mirror unchanged",
+               names[i]);
+      check(untouched, what);
+    }
+  }
+
+  // A forged run with valid CRCs that runs off the end of the mirror
+  DeltaBuffer forged;
+  forged.write(one.bytes.data(), 12);
+  uint8_t junk[16];
+  memset(junk, 0x5A, sizeof(junk));
+  runHeader(forged, mirror.getSize() - 8, sizeof(junk));
+  forged.write(junk, sizeof(junk));
+  uint16_t crc = crc16(0xFFFF, junk, sizeof(junk));
+  forged.write((uint8_t)(crc & 0xFF));
+  forged.write((uint8_t)(crc >> 8));
+  runHeader(forged, 1, 0);
+  check(!apply(forged, old, -1, &untouched) && untouched,
+        "out-of-bounds run rejected, mirror unchanged");
+
+  // A delta that does not start at the mirror's sequence
+  check(!apply(stale, old, -1, &untouched) && untouched,
+        "delta from another sequence rejected, mirror unchanged");
+
+  // The intact delta still applies afterwards
+  at = apply(one, old, -1, &untouched);
+  check(at == changes.sequence() && same(), "retry after rejects matches");
+
+  printf("%s\n", failures ? "FAIL" : "PASS");
+  return failures ? 1 : 0;
+}
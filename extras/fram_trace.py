@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-3-Clause
+"""Decode and replay Adafruit_FRAM_SPI_Trace dumps on the host.
+
+A dump is the byte image written by Adafruit_FRAM_SPI_Trace::writeTo() (for
+example a Serial capture) or saved with saveTo() and read back from FRAM.
+Leading bytes before the 'FT' header are skipped, so raw captures work.
+
+  fram_trace.py decode dump.bin
+  fram_trace.py replay dump.bin --clock 1e6 8e6 --cache 0 256 --auto-wren
+  fram_trace.py replay dump.bin --part MB85RS4MTY --sleep-after 0 5 50
+
+'replay' runs the trace through a timing and energy model of the SPI FRAM
+bus and prints the modeled bus time and FRAM energy for every combination of
+the given options, next to the baseline (the trace as recorded at the first
+clock rate, never sleeping). Idle gaps come from the recorded timestamps; a
+sleep policy puts the part to sleep once a gap exceeds the idle timeout and
+charges the wake-up on the next transfer.
+"""
+
+import argparse
+import collections
+import itertools
+import struct
+import sys
+
+HEADER = struct.Struct("<2sBBII")
+ENTRY = struct.Struct("<IIIBBBx")
+
+OPCODES = {
+    0x06: "WREN",
+    0x04: "WRDI",
+    0x05: "RDSR",
+    0x01: "WRSR",
+    0x03: "READ",
+    0x02: "WRITE",
+    0x9F: "RDID",
+    0xB9: "SLEEP",
+    0xBA: "DPD",
+    0x00: "WAKE",
+}
+OPS = ["read", "write", "read8", "write8", "status", "wake", "control"]
+
+# Typical currents mirroring the power profiles in Adafruit_FRAM_SPI.cpp:
+# read uA, write uA, standby uA, deepest low-power mode (wake us, nA)
+PARTS = {
+    "MB85RS64V": (1500, 1500, 10, None),
+    "MB85RS64T": (2000, 2000, 50, (400, 10000)),
+    "MB85RS1MT": (2000, 2000, 50, (400, 10000)),
+    "MB85RS4MTY": (2000, 2000, 100, (450, 100)),
+    "FM25V02": (2500, 2500, 150, None),
+    "MR45V064B": (2000, 2000, 50, None),
+}
+
+Entry = collections.namedtuple("Entry", "timestamp addr length opcode op ok")
+
+
+def load(path):
+    """Returns (entries, dropped) from a dump file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    start = data.find(b"FT")
+    while start >= 0:
+        if len(data) - start >= HEADER.size:
+            fields = HEADER.unpack_from(data, start)
+            magic, version, esize, count, dropped = fields
+            if version == 1 and esize == ENTRY.size:
+                break
+        start = data.find(b"FT", start + 1)
+    if start < 0:
+        sys.exit("%s: no trace header found" % path)
+    pos = start + HEADER.size
+    avail = (len(data) - pos) // ENTRY.size
+    if avail < count:
+        print("warning: header says %d entries, %d present" % (count, avail),
+              file=sys.stderr)
+        count = avail
+    entries = [Entry(*ENTRY.unpack_from(data, pos + i * ENTRY.size))
+               for i in range(count)]
+    return entries, dropped
+
+
+def decode(args):
+    entries, dropped = load(args.dump)
+    print("# %d entries, %d dropped" % (len(entries), dropped))
+    print("timestamp,delta_us,op,opcode,addr,length,ok")
+    prev = entries[0].timestamp if entries else 0
+    for e in entries:
+        print("%d,%d,%s,%s,0x%06X,%d,%d" % (
+            e.timestamp, (e.timestamp - prev) & 0xFFFFFFFF,
+            OPS[e.op] if e.op < len(OPS) else e.op,
+            OPCODES.get(e.opcode, "0x%02X" % e.opcode), e.addr, e.length,
+            e.ok))
+        prev = e.timestamp
+
+
+class BusModel:
+    """Timing model of one SPI FRAM behind the driver.
+
+    Every CS-framed transfer costs a fixed software/CS overhead plus eight
+    clocks per byte; a wake costs the full tREC.
+    """
+
+    def __init__(self, clock, addr_bytes, txn_us, wake_us, cache_bytes,
+                 line_bytes, auto_wren, part, volts, sleep_after_ms):
+        self.read_ua, self.write_ua, self.standby_ua, lp = part
+        self.volts = volts
+        self.sleep_after_us = (None if sleep_after_ms is None or not lp
+                               else sleep_after_ms * 1000.0)
+        self.sleep_na = lp[1] if lp else 0
+        if lp:
+            wake_us = lp[0]
+        self.uj = 0.0
+        self.asleep = False
+        self.last_ts = None
+        self.last_us = 0.0
+        self.clock = clock
+        self.addr_bytes = addr_bytes
+        self.txn_us = txn_us
+        self.wake_us = wake_us
+        self.auto_wren = auto_wren
+        self.line = line_bytes
+        self.lines = cache_bytes // line_bytes if cache_bytes else 0
+        self.cache = collections.OrderedDict()
+        self.us = 0.0
+        self.transfers = 0
+
+    def _xfer(self, nbytes, ua=None):
+        t = self.txn_us + nbytes * 8e6 / self.clock
+        self.us += t
+        self.uj += (ua or self.read_ua) * t * self.volts * 1e-6
+        self.transfers += 1
+
+    def _idle(self, timestamp):
+        """Charges the gap before a transfer starting at timestamp."""
+        if self.last_ts is None:
+            return
+        delta = (timestamp - self.last_ts) & 0xFFFFFFFF
+        gap = max(0.0, delta - self.last_us)
+        awake = gap
+        if self.sleep_after_us is not None and gap > self.sleep_after_us:
+            awake = self.sleep_after_us
+            self.uj += self.sleep_na * (gap - awake) * self.volts * 1e-9
+            self.asleep = True
+        self.uj += self.standby_ua * awake * self.volts * 1e-6
+
+    def _read(self, addr, length):
+        if not self.lines:
+            self._xfer(1 + self.addr_bytes + length)
+            return
+        first = addr // self.line
+        last = (addr + max(length, 1) - 1) // self.line
+        for ln in range(first, last + 1):
+            if ln in self.cache:
+                self.cache.move_to_end(ln)
+                continue
+            self._xfer(1 + self.addr_bytes + self.line)
+            self.cache[ln] = True
+            if len(self.cache) > self.lines:
+                self.cache.popitem(last=False)
+
+    def _wake(self):
+        self.us += self.wake_us
+        self.uj += self.standby_ua * self.wake_us * self.volts * 1e-6
+        self.transfers += 1
+
+    def feed(self, e):
+        name = OPCODES.get(e.opcode)
+        before = self.us
+        self._idle(e.timestamp)
+        woke = self.asleep
+        if self.asleep:
+            self._wake()
+            self.asleep = False
+        if e.op == 5:
+            # The recorded wake; already charged if the model slept too
+            if not woke:
+                self._wake()
+        elif name == "READ":
+            self._read(e.addr, e.length)
+        elif name == "WRITE":
+            # Write-through: cached lines stay valid with the new data
+            if self.auto_wren:
+                self._xfer(1)
+            self._xfer(1 + self.addr_bytes + e.length, self.write_ua)
+        elif name in ("WREN", "WRDI") and self.auto_wren:
+            pass  # issued by the driver around each write instead
+        elif name == "RDID":
+            self._xfer(1 + e.length)
+        else:
+            self._xfer(1 + e.length)
+        self.last_ts = e.timestamp
+        self.last_us = self.us - before
+
+
+def replay(args):
+    entries, dropped = load(args.dump)
+    if not entries:
+        sys.exit("empty trace")
+    addr_bytes = args.addr_bytes
+    if not addr_bytes:
+        top = max(e.addr + e.length for e in entries)
+        addr_bytes = 3 if top > 0x10000 else 2
+
+    part = PARTS[args.part]
+
+    def run(clock, cache, auto_wren, sleep_after=None):
+        m = BusModel(clock, addr_bytes, args.txn_us, args.wake_us, cache,
+                     args.line, auto_wren, part, args.voltage, sleep_after)
+        for e in entries:
+            m.feed(e)
+        return m
+
+    span = (entries[-1].timestamp - entries[0].timestamp) & 0xFFFFFFFF
+    print("# %d entries (%d dropped), recorded span %d us, %d-byte addresses"
+          % (len(entries), dropped, span, addr_bytes))
+    base = run(args.clock[0], 0, False)
+    print("# %s at %.2f V" % (args.part, args.voltage))
+    print("%-10s %-8s %-9s %-9s %10s %12s %8s %12s" % (
+        "clock_hz", "cache_b", "auto_wren", "sleep_ms", "transfers", "bus_us",
+        "vs_base", "energy_uj"))
+    wrens = args.auto_wren and [False, True] or [False]
+    sleeps = args.sleep_after or [None]
+    for clock, cache, aw, sl in itertools.product(args.clock, args.cache,
+                                                  wrens, sleeps):
+        m = run(clock, cache, aw, sl)
+        print("%-10d %-8d %-9s %-9s %10d %12.1f %7.2fx %12.3f" % (
+            clock, cache, "yes" if aw else "no",
+            "never" if sl is None else "%g" % sl, m.transfers, m.us,
+            m.us / base.us if base.us else 0, m.uj))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    sub = p.add_subparsers(dest="cmd", required=True)
+
+    d = sub.add_parser("decode", help="print a dump as CSV")
+    d.add_argument("dump")
+    d.set_defaults(func=decode)
+
+    r = sub.add_parser("replay", help="model bus time under other configs")
+    r.add_argument("dump")
+    r.add_argument("--clock", type=float, nargs="+", default=[1e6],
+                   help="SPI clock rates in Hz (first one is the baseline)")
+    r.add_argument("--cache", type=int, nargs="+", default=[0],
+                   help="read cache sizes in bytes, 0 for none")
+    r.add_argument("--line", type=int, default=32,
+                   help="cache line size in bytes")
+    r.add_argument("--auto-wren", action="store_true",
+                   help="also model the driver issuing WREN per write")
+    r.add_argument("--addr-bytes", type=int, default=0,
+                   help="address size, guessed from the trace by default")
+    r.add_argument("--txn-us", type=float, default=5.0,
+                   help="fixed per-transfer overhead in us")
+    r.add_argument("--wake-us", type=float, default=400.0,
+                   help="sleep recovery time in us, if the part has none")
+    r.add_argument("--part", choices=sorted(PARTS), default="MB85RS64T",
+                   help="power profile used for the energy estimate")
+    r.add_argument("--voltage", type=float, default=3.3,
+                   help="FRAM supply voltage")
+    r.add_argument("--sleep-after", type=float, nargs="+",
+                   help="auto-sleep idle timeouts in ms to compare")
+    r.set_defaults(func=replay)
+
+    args = p.parse_args()
+    if args.cmd == "replay":
+        args.clock = [int(c) for c in args.clock]
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
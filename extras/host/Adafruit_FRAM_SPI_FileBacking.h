@@ -0,0 +1,88 @@
+/*!
+ *  @file Adafruit_FRAM_SPI_FileBacking.h
+ *
+ *  Adafruit_FRAM_SPI_Backing over a stdio FILE, for running
+ *  Adafruit_FRAM_SPI_Tier on a host. Bytes past the end of the file read
+ *  as zero, as they would after a write further out.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#ifndef _ADAFRUIT_FRAM_SPI_FILEBACKING_H_
+#define _ADAFRUIT_FRAM_SPI_FILEBACKING_H_
+
+#include "Adafruit_FRAM_SPI_Tier.h"
+#include <stdio.h>
+
+/*!
+ *  @brief  Backing store kept in a file opened for update ("w+b", "r+b"
+ *          or tmpfile()), owned by the caller
+ */
+class Adafruit_FRAM_SPI_FileBacking : public Adafruit_FRAM_SPI_Backing {
+public:
+  uint32_t reads;  ///< read() calls
+  uint32_t writes; ///< write() calls
+  uint32_t syncs;  ///< sync() calls
+
+  /*!
+   *  @brief  Wraps an open file
+   *  @param  file
+   *          File opened for reading and writing
+   */
+  Adafruit_FRAM_SPI_FileBacking(FILE *file) : _file(file) {
+    reads = writes = syncs = 0;
+  }
+
+  /*!
+   *  @brief  Reads from the file
+   *  @param  addr
+   *          Byte offset
+   *  @param  buf
+   *          Destination
+   *  @param  len
+   *          Number of bytes
+   *  @return true on success
+   */
+  bool read(uint32_t addr, uint8_t *buf, size_t len) {
+    reads++;
+    if (!_file || fseek(_file, addr, SEEK_SET)) {
+      return false;
+    }
+    size_t n = fread(buf, 1, len, _file);
+    if (n < len && ferror(_file)) {
+      return false;
+    }
+    memset(buf + n, 0, len - n);
+    return true;
+  }
+
+  /*!
+   *  @brief  Writes to the file
+   *  @param  addr
+   *          Byte offset
+   *  @param  buf
+   *          Data to write
+   *  @param  len
+   *          Number of bytes
+   *  @return true on success
+   */
+  bool write(uint32_t addr, const uint8_t *buf, size_t len) {
+    writes++;
+    return _file && !fseek(_file, addr, SEEK_SET) &&
+           fwrite(buf, 1, len, _file) == len;
+  }
+
+  /*!
+   *  @brief  Flushes stdio buffers to the file
+   *  @return true on success
+   */
+  bool sync(void) {
+    syncs++;
+    return _file && !fflush(_file);
+  }
+
+private:
+  FILE *_file;
+};
+
+#endif
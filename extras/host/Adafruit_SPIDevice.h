@@ -0,0 +1,129 @@
+// Host stand-in for BusIO: MB85RS64V parts (8 KB) in RAM, one per chip
+// select pin modulo HOST_FRAM_DEVICES. It is deliberately not
+// thread-safe and counts transfers that overlap, which the queue must
+// never allow.
+#ifndef _HOST_SPIDEVICE_H_
+#define _HOST_SPIDEVICE_H_
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <atomic>
+
+/// Number of simulated parts
+#define HOST_FRAM_DEVICES 4
+
+typedef enum { SPI_BITORDER_MSBFIRST, SPI_BITORDER_LSBFIRST } BusIOBitOrder;
+
+/// Simulated part
+struct HostFram {
+  uint8_t mem[8192];           ///< Array contents
+  uint8_t status;              ///< Status register, without WEL
+  bool wel;                    ///< Write enable latch
+  uint32_t failAfter;          ///< Bytes stored before power fails, 0 never
+  bool off;                    ///< Power failed, further writes are lost
+  std::atomic<int> busy;       ///< Transfers in progress
+  std::atomic<uint32_t> clash; ///< Transfers that overlapped another
+};
+extern HostFram hostFram[HOST_FRAM_DEVICES];
+
+class Adafruit_SPIDevice {
+public:
+  Adafruit_SPIDevice(int8_t cs, uint32_t = 1000000,
+                     BusIOBitOrder = SPI_BITORDER_MSBFIRST, uint8_t = 0,
+                     SPIClass * = &SPI)
+      : _part(hostFram[cs % HOST_FRAM_DEVICES]) {}
+  Adafruit_SPIDevice(int8_t cs, int8_t, int8_t, int8_t, uint32_t = 1000000,
+                     BusIOBitOrder = SPI_BITORDER_MSBFIRST, uint8_t = 0)
+      : _part(hostFram[cs % HOST_FRAM_DEVICES]) {}
+
+  bool begin(void) { return true; }
+  bool write(const uint8_t *buf, size_t len, const uint8_t *pre = NULL,
+             size_t preLen = 0) {
+    return transfer(pre, preLen, buf, len, NULL, 0);
+  }
+  bool write_then_read(const uint8_t *out, size_t outLen, uint8_t *in,
+                       size_t inLen, uint8_t = 0xFF) {
+    return transfer(out, outLen, NULL, 0, in, inLen);
+  }
+  void beginTransactionWithAssertingCS(void) {}
+  void endTransactionWithDeassertingCS(void) {}
+
+private:
+  // Stores one byte of a WRITE unless power has failed
+  bool store(uint32_t addr, uint8_t value) {
+    if (_part.off) {
+      return false;
+    }
+    _part.mem[addr & 0x1FFF] = value;
+    if (_part.failAfter && !--_part.failAfter) {
+      _part.off = true;
+    }
+    return true;
+  }
+
+  // Opcode and address come first, in head; body is the WRITE payload
+  bool transfer(const uint8_t *head, size_t headLen, const uint8_t *body,
+                size_t bodyLen, uint8_t *in, size_t inLen) {
+    if (!headLen) {
+      head = body;
+      headLen = bodyLen;
+      body = NULL;
+      bodyLen = 0;
+    }
+    if (_part.busy.fetch_add(1)) {
+      _part.clash++;
+    }
+    std::this_thread::yield();
+    bool ok = true;
+    uint32_t addr = headLen >= 3 ? (head[1] << 8 | head[2]) & 0x1FFF : 0;
+    switch (head[0]) {
+    case 0x06: // WREN
+      _part.wel = true;
+      break;
+    case 0x04: // WRDI
+      _part.wel = false;
+      break;
+    case 0x05: // RDSR
+      if (inLen) {
+        in[0] = _part.status | (_part.wel ? 0x02 : 0);
+      }
+      break;
+    case 0x01: // WRSR
+      if (_part.wel && headLen > 1) {
+        _part.status = head[1] & 0x8C;
+      }
+      _part.wel = false;
+      break;
+    case 0x03: // READ
+      for (size_t i = 0; i < inLen; i++) {
+        in[i] = _part.mem[(addr + i) & 0x1FFF];
+      }
+      break;
+    case 0x02: // WRITE
+      if (_part.wel) {
+        for (size_t i = 3; i < headLen && ok; i++) {
+          ok = store(addr + i - 3, head[i]);
+        }
+        addr += headLen > 3 ? headLen - 3 : 0;
+        for (size_t i = 0; i < bodyLen && ok; i++) {
+          ok = store(addr + i, body[i]);
+        }
+      }
+      _part.wel = false;
+      break;
+    case 0x9F: { // RDID, MB85RS64V
+      static const uint8_t id[4] = {0x04, 0x7F, 0x03, 0x02};
+      for (size_t i = 0; i < inLen && i < 4; i++) {
+        in[i] = id[i];
+      }
+      break;
+    }
+    }
+    _part.busy--;
+    return ok;
+  }
+
+  HostFram &_part;
+};
+
+#endif
@@ -0,0 +1,89 @@
+// Host stand-in for the parts of the Arduino core the driver uses
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#define DEC 10
+#define F(s) s
+#define HEX 16
+
+inline uint32_t micros(void) {
+  using namespace std::chrono;
+  static const steady_clock::time_point t0 = steady_clock::now();
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now() - t0)
+      .count();
+}
+inline uint32_t millis(void) { return micros() / 1000; }
+inline void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+inline void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+inline void yield(void) { std::this_thread::yield(); }
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (len--) {
+      n += write(*buf++);
+    }
+    return n;
+  }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(unsigned long v, int base = DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", v);
+    return print(buf);
+  }
+  size_t print(long v, int base = DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%ld", v);
+    return print(buf);
+  }
+  size_t print(unsigned int v, int base = DEC) {
+    return print((unsigned long)v, base);
+  }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t println(void) { return print("\r\n"); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+  template <typename T> size_t println(T v, int base) {
+    return print(v, base) + println();
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+  size_t readBytes(uint8_t *buf, size_t len) {
+    size_t n = 0;
+    for (int c; n < len && (c = read()) >= 0; n++) {
+      buf[n] = (uint8_t)c;
+    }
+    return n;
+  }
+};
+
+class HostSerial : public Stream {
+public:
+  size_t write(uint8_t c) { return putchar(c) == EOF ? 0 : 1; }
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+  int peek(void) { return -1; }
+};
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,10 @@
+// Host stand-in for the Arduino SPI library
+#ifndef _HOST_SPI_H_
+#define _HOST_SPI_H_
+
+#define SPI_MODE0 0
+
+class SPIClass {};
+extern SPIClass SPI;
+
+#endif
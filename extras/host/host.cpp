@@ -0,0 +1,6 @@
+// Globals the host stand-ins declare, shared by every test under extras/
+#include <Adafruit_SPIDevice.h>
+
+HostSerial Serial;
+SPIClass SPI;
+HostFram hostFram[HOST_FRAM_DEVICES];
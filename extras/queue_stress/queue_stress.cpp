@@ -0,0 +1,114 @@
+/*!
+ *  @file queue_stress.cpp
+ *
+ *  Host stress test for Adafruit_FRAM_SPI_Queue. Eight std::thread
+ *  producers hammer one FRAM through the queue while a single executor
+ *  thread polls it. The simulated part in extras/host counts transfers that
+ *  overlap, so any request that reaches the driver outside the executor
+ *  shows up. Build and run from the library root on Linux:
+ *
+ *      g++ -std=c++11 -O2 -pthread -Iextras/host -I. \
+ *          extras/queue_stress/queue_stress.cpp extras/host/host.cpp \
+ *          Adafruit_FRAM_SPI.cpp Adafruit_FRAM_SPI_Queue.cpp \
+ *          Adafruit_FRAM_SPI_Changes.cpp Adafruit_FRAM_SPI_Heatmap.cpp \
+ *          Adafruit_FRAM_SPI_Histogram.cpp Adafruit_FRAM_SPI_Trace.cpp \
+ *          -o queue_stress && ./queue_stress
+ *
+ *  Adding -fsanitize=thread also checks the queue's memory ordering.
+ *
+ *  BSD license, all text above must be included in any redistribution
+ */
+
+#include "Adafruit_FRAM_SPI_Queue.h"
+#include <thread>
+#include <vector>
+
+#define PRODUCERS 8 // Submitting threads
+#define ROUNDS 2000 // Write-then-read pairs per thread
+#define SLICE 1024  // FRAM bytes owned by each thread
+#define RECORD 64   // Bytes per write
+
+static Adafruit_FRAM_SPI fram(0);
+static Adafruit_FRAM_SPI_Queue queue(fram);
+static std::atomic<uint32_t> failures(0);
+
+// FRAM_REQ_CALL body, runs on the executor
+static bool readStatus(Adafruit_FRAM_SPI &f, void *arg) {
+  *(uint8_t *)arg = f.getStatusRegister();
+  return true;
+}
+
+// One producer: blocking writes and reads of its own slice, then a batch
+// of asynchronous writes and a call
+static void producer(uint8_t id) {
+  uint8_t out[RECORD], in[RECORD];
+  for (int i = 0; i < ROUNDS; i++) {
+    uint32_t addr = id * SLICE + (i % (SLICE / RECORD)) * RECORD;
+    memset(out, (uint8_t)(id * 31 + i), sizeof(out));
+    if (!queue.write(addr, out, sizeof(out)) ||
+        !queue.read(addr, in, sizeof(in)) || memcmp(out, in, sizeof(in))) {
+      failures++;
+    }
+  }
+
+  fram_spi_request_t reqs[4];
+  uint8_t data[4][8];
+  for (uint8_t k = 0; k < 4; k++) {
+    memset(data[k], id ^ k, sizeof(data[k]));
+    reqs[k].op = FRAM_REQ_WRITE;
+    reqs[k].addr = id * SLICE + k * sizeof(data[k]);
+    reqs[k].data = data[k];
+    reqs[k].len = sizeof(data[k]);
+    reqs[k].complete = NULL;
+    reqs[k].state.store(FRAM_REQ_IDLE);
+    if (!queue.submit(&reqs[k])) {
+      failures++;
+    }
+  }
+  for (uint8_t k = 0; k < 4; k++) {
+    if (!Adafruit_FRAM_SPI_Queue::wait(&reqs[k])) {
+      failures++;
+    }
+  }
+  uint8_t status;
+  if (!queue.call(readStatus, &status)) {
+    failures++;
+  }
+}
+
+int main(void) {
+  if (!fram.begin()) {
+    printf("FAIL: no FRAM\n");
+    return 1;
+  }
+
+  std::atomic<bool> stop(false);
+  std::atomic<uint32_t> executed(0);
+  std::thread executor([&] {
+    while (!stop.load()) {
+      uint32_t n = queue.poll();
+      executed += n;
+      if (!n) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<std::thread> producers;
+  for (uint8_t id = 0; id < PRODUCERS; id++) {
+    producers.emplace_back(producer, id);
+  }
+  for (size_t i = 0; i < producers.size(); i++) {
+    producers[i].join();
+  }
+  stop = true;
+  executor.join();
+
+  uint32_t expected = PRODUCERS * (2 * ROUNDS + 5);
+  printf("requests %u/%u, failures %u, overlapping transfers %u\n",
+         (unsigned)executed.load(), (unsigned)expected,
+         (unsigned)failures.load(), (unsigned)hostFram[0].clash.load());
+  bool ok = executed == expected && !failures && !hostFram[0].clash;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}